@@ -42,475 +42,2214 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "TinyGPS.h"
 
-#define _GPRMC_TERM   "GPRMC"
-#define _GPGGA_TERM   "GPGGA"
-#define _GPGSA_TERM   "GPGSA"
-#define _GNRMC_TERM   "GNRMC"
-#define _GNGNS_TERM   "GNGNS"
-#define _GNGSA_TERM   "GNGSA"
-#define _GPGSV_TERM   "GPGSV"
-#define _GLGSV_TERM   "GLGSV"
-#define _GPZDA_TERM   "GPZDA"
-#define _PUBX_TERM    "PUBX"
+// encode() screens ordinary characters a block at a time, see scan_run()
+#if !defined(_GPS_NO_SIMD) && defined(__SSE2__)
+#define _GPS_SCAN_SSE2
+#include <emmintrin.h>
+#elif !defined(_GPS_NO_SIMD) && defined(__ARM_NEON)
+#define _GPS_SCAN_NEON
+#include <arm_neon.h>
+#elif !defined(_GPS_NO_SIMD) && !defined(__AVR__)
+#define _GPS_SCAN_SWAR
+#endif
+
+// sentence identifiers packed 5 bits per letter for the term 0 dispatch
+#define _GPS_PACK2(a, b)    ((((unsigned)(a) & 0x1F) << 5) | ((b) & 0x1F))
+#define _GPS_PACK3(a, b, c) ((_GPS_PACK2(a, b) << 5) | ((c) & 0x1F))
+
+#ifndef _GPS_NO_UBX
+// UBX frames: two sync characters, class, id, little-endian payload length,
+// payload, and a two byte Fletcher checksum over class through payload
+#define _GPS_UBX_SYNC1 0xB5
+#define _GPS_UBX_SYNC2 0x62
+// class << 8 | id of the messages decoded
+#define _GPS_UBX_NAV_DOP     0x0104
+#define _GPS_UBX_NAV_PVT     0x0107
+#define _GPS_UBX_NAV_TIMEUTC 0x0121
+#define _GPS_UBX_NAV_SAT     0x0135
+
+enum {
+  _GPS_UBX_IDLE, _GPS_UBX_SYNC, _GPS_UBX_CLASS, _GPS_UBX_ID, _GPS_UBX_LENGTH1,
+  _GPS_UBX_LENGTH2, _GPS_UBX_PAYLOAD, _GPS_UBX_CK_A, _GPS_UBX_CK_B
+};
+#endif
+
+// field parsers referenced by the sentence schemas below
+enum {
+  _GPS_FIELD_TIME, _GPS_FIELD_RMC_STATUS, _GPS_FIELD_LATITUDE, _GPS_FIELD_NS,
+  _GPS_FIELD_LONGITUDE, _GPS_FIELD_EW, _GPS_FIELD_CONSTELLATIONS, _GPS_FIELD_SPEED,
+  _GPS_FIELD_COURSE, _GPS_FIELD_DATE, _GPS_FIELD_DAY, _GPS_FIELD_MONTH, _GPS_FIELD_YEAR,
+  _GPS_FIELD_GGA_QUALITY, _GPS_FIELD_NUMSATS, _GPS_FIELD_HDOP, _GPS_FIELD_ALTITUDE,
+  _GPS_FIELD_UBX_MESSAGE, _GPS_FIELD_UBX_NAVSTAT, _GPS_FIELD_GSA_PRN, _GPS_FIELD_GSA_SYSTEM,
+  _GPS_FIELD_GSV_TOTAL, _GPS_FIELD_GSV_MESSAGE, _GPS_FIELD_SPEED_KMH,
+  _GPS_FIELD_VERTICAL_SPEED, _GPS_FIELD_VTG_MODE,
+  _GPS_FIELD_GSV_SATELLITES  // repeats every 4 terms: PRN, elevation, azimuth, SNR
+};
+
+#define _GPS_FIELD_END { 0xFF, 0 }
+
+// Per sentence field schemas: (term number, parser) pairs in ascending term
+// order, walked in step with the terms as they arrive
+static const TinyGPS::FieldDesc _gps_fields_none[] PROGMEM = {
+  _GPS_FIELD_END
+};
+
+static const TinyGPS::FieldDesc _gps_fields_gga[] PROGMEM = {
+  { 1, _GPS_FIELD_TIME }, { 2, _GPS_FIELD_LATITUDE }, { 3, _GPS_FIELD_NS },
+  { 4, _GPS_FIELD_LONGITUDE }, { 5, _GPS_FIELD_EW }, { 6, _GPS_FIELD_GGA_QUALITY },
+  { 7, _GPS_FIELD_NUMSATS }, { 8, _GPS_FIELD_HDOP }, { 9, _GPS_FIELD_ALTITUDE },
+  _GPS_FIELD_END
+};
+
+static const TinyGPS::FieldDesc _gps_fields_rmc[] PROGMEM = {
+  { 1, _GPS_FIELD_TIME }, { 2, _GPS_FIELD_RMC_STATUS }, { 3, _GPS_FIELD_LATITUDE },
+  { 4, _GPS_FIELD_NS }, { 5, _GPS_FIELD_LONGITUDE }, { 6, _GPS_FIELD_EW },
+  { 7, _GPS_FIELD_SPEED }, { 8, _GPS_FIELD_COURSE }, { 9, _GPS_FIELD_DATE },
+  _GPS_FIELD_END
+};
+
+#ifndef _GPS_NO_GNS
+static const TinyGPS::FieldDesc _gps_fields_gns[] PROGMEM = {
+  { 1, _GPS_FIELD_TIME }, { 2, _GPS_FIELD_LATITUDE }, { 3, _GPS_FIELD_NS },
+  { 4, _GPS_FIELD_LONGITUDE }, { 5, _GPS_FIELD_EW }, { 6, _GPS_FIELD_CONSTELLATIONS },
+  { 7, _GPS_FIELD_NUMSATS },
+  _GPS_FIELD_END
+};
+
+#endif
+
+#ifndef _GPS_NO_GSV
+static const TinyGPS::FieldDesc _gps_fields_gsv[] PROGMEM = {
+  { 1, _GPS_FIELD_GSV_TOTAL }, { 2, _GPS_FIELD_GSV_MESSAGE }, { 4, _GPS_FIELD_GSV_SATELLITES },
+  _GPS_FIELD_END
+};
+
+#ifndef _GPS_NO_GSA
+static const TinyGPS::FieldDesc _gps_fields_gsa[] PROGMEM = {
+  { 3, _GPS_FIELD_GSA_PRN }, { 4, _GPS_FIELD_GSA_PRN }, { 5, _GPS_FIELD_GSA_PRN },
+  { 6, _GPS_FIELD_GSA_PRN }, { 7, _GPS_FIELD_GSA_PRN }, { 8, _GPS_FIELD_GSA_PRN },
+  { 9, _GPS_FIELD_GSA_PRN }, { 10, _GPS_FIELD_GSA_PRN }, { 11, _GPS_FIELD_GSA_PRN },
+  { 12, _GPS_FIELD_GSA_PRN }, { 13, _GPS_FIELD_GSA_PRN }, { 14, _GPS_FIELD_GSA_PRN },
+  { 18, _GPS_FIELD_GSA_SYSTEM },
+  _GPS_FIELD_END
+};
+#endif
+
+#endif
+
+#ifndef _GPS_NO_ZDA
+static const TinyGPS::FieldDesc _gps_fields_zda[] PROGMEM = {
+  { 1, _GPS_FIELD_TIME }, { 2, _GPS_FIELD_DAY }, { 3, _GPS_FIELD_MONTH },
+  { 4, _GPS_FIELD_YEAR },
+  _GPS_FIELD_END
+};
+
+#endif
+
+#ifndef _GPS_NO_VTG
+static const TinyGPS::FieldDesc _gps_fields_vtg[] PROGMEM = {
+  { 1, _GPS_FIELD_COURSE }, { 5, _GPS_FIELD_SPEED }, { 9, _GPS_FIELD_VTG_MODE },
+  _GPS_FIELD_END
+};
+
+#endif
+
+#ifndef _GPS_NO_PUBX
+static const TinyGPS::FieldDesc _gps_fields_pubx[] PROGMEM = {
+  { 1, _GPS_FIELD_UBX_MESSAGE },
+  _GPS_FIELD_END
+};
+
+static const TinyGPS::FieldDesc _gps_fields_pubx00[] PROGMEM = { // Lat/Long Position Data
+  { 2, _GPS_FIELD_TIME }, { 3, _GPS_FIELD_LATITUDE }, { 4, _GPS_FIELD_NS },
+  { 5, _GPS_FIELD_LONGITUDE }, { 6, _GPS_FIELD_EW }, { 7, _GPS_FIELD_ALTITUDE },
+  { 8, _GPS_FIELD_UBX_NAVSTAT }, { 11, _GPS_FIELD_SPEED_KMH }, { 12, _GPS_FIELD_COURSE },
+#ifndef _GPS_NO_KINEMATICS
+  { 13, _GPS_FIELD_VERTICAL_SPEED },
+#endif
+  { 15, _GPS_FIELD_HDOP }, { 18, _GPS_FIELD_NUMSATS },
+  _GPS_FIELD_END
+};
+
+static const TinyGPS::FieldDesc _gps_fields_pubx04[] PROGMEM = { // Time of Day and Clock Information
+  { 2, _GPS_FIELD_TIME }, { 3, _GPS_FIELD_DATE },
+  _GPS_FIELD_END
+};
+
+#endif
+
+// indexed by sentence type, disabled sentences resolve to _GPS_SENTENCE_OTHER
+static const TinyGPS::FieldDesc *const _gps_sentence_fields[] = {
+  _gps_fields_gga, _gps_fields_rmc,
+#ifndef _GPS_NO_GNS
+  _gps_fields_gns,
+#else
+  _gps_fields_none,
+#endif
+#if !defined(_GPS_NO_GSA) && !defined(_GPS_NO_GSV)
+  _gps_fields_gsa,
+#else
+  _gps_fields_none /* GSA */,
+#endif
+#ifndef _GPS_NO_GSV
+  _gps_fields_gsv,
+#else
+  _gps_fields_none,
+#endif
+#ifndef _GPS_NO_ZDA
+  _gps_fields_zda,
+#else
+  _gps_fields_none,
+#endif
+#ifndef _GPS_NO_VTG
+  _gps_fields_vtg,
+#else
+  _gps_fields_none,
+#endif
+#ifndef _GPS_NO_PUBX
+  _gps_fields_pubx,
+#else
+  _gps_fields_none,
+#endif
+  _gps_fields_none /* UBX */,
+  _gps_fields_none /* OTHER */
+};
+
+// two decimal digits, or 0xFF if either is not a digit, which no range
+// check of a time or date accepts
+static byte _gps_two_digits(const char *p)
+{
+  if (p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9')
+    return 0xFF;
+  return 10 * (p[0] - '0') + (p[1] - '0');
+}
+
+// days before the first of each month in a common year
+static const uint16_t _gps_days_before_month[] PROGMEM = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
 
 TinyGPS::TinyGPS()
-  :  _time(GPS_INVALID_TIME)
-  ,  _date(GPS_INVALID_DATE)
-  ,  _latitude(GPS_INVALID_ANGLE)
-  ,  _longitude(GPS_INVALID_ANGLE)
-  ,  _altitude(GPS_INVALID_ALTITUDE)
-  ,  _speed(GPS_INVALID_SPEED)
-  ,  _course(GPS_INVALID_ANGLE)
-  ,  _hdop(GPS_INVALID_HDOP)
-  ,  _numsats(GPS_INVALID_SATELLITES)
-  ,  _last_time_fix(GPS_INVALID_FIX_TIME)
-  ,  _last_position_fix(GPS_INVALID_FIX_TIME)
-  ,  _year(GPS_INVALID_DATE)
-  ,  _month(GPS_INVALID_DATE)
-  ,  _day(GPS_INVALID_DATE)
-  ,  _last_date_fix(GPS_INVALID_FIX_TIME)
+  :  _fix_seq(0)
+#ifdef _GPS_MERGE_EPOCHS
+  ,  _held_changed(0)
+  ,  _held_score(0)
+  ,  _quality(0)
+#endif
+#ifdef _GPS_LAZY_DECODE
+  ,  _commits(0)
+  ,  _parsed_seq(0)
+#endif
+  ,  _field(_gps_fields_none)
   ,  _parity(0)
   ,  _is_checksum_term(false)
   ,  _sentence_type(_GPS_SENTENCE_OTHER)
+  ,  _talker(_GPS_TALKER_OTHER)
+#ifndef _GPS_NO_PUBX
   ,  _UBX_message_type(0)
+#endif
   ,  _term_number(0)
   ,  _term_offset(0)
   ,  _gps_data_good(false)
+  ,  _in_sentence(false)
+  ,  _sentence_time(0)
+  ,  _clock(0)
+  ,  _clock_context(0)
+  ,  _sentence_filter(0xFFFF)
+#ifndef _GPS_NO_EPOCH
+  ,  _date_year(0xFF)
+  ,  _epoch_date(0)
+  ,  _epoch_day(0)
+#endif
+#ifndef _GPS_NO_UBX
+  ,  _ubx_state(_GPS_UBX_IDLE)
+  ,  _ubx_message(0)
+  ,  _ubx_length(0)
+  ,  _ubx_offset(0)
+  ,  _ubx_ck_a(0)
+  ,  _ubx_ck_b(0)
+  ,  _ubx_value(0)
+  ,  _ubx_date(0)
+  ,  _ubx_time(0)
+  ,  _ubx_nano(0)
+  ,  _ubx_hdop(0xFFFF)
+  ,  _ubx_sat_byte(0)
+#endif
+#ifndef _GPS_NO_GSV
+  ,  _gsv_total(0)
+  ,  _gsv_message(0)
+  ,  _gsv_base(_GPS_MAX_SATELLITES)
+  ,  _gsv_staged(0)
+  ,  _gsv_next(0)
+  ,  _gsv_constellation(0)
+#ifndef _GPS_NO_GSA
+  ,  _gsa_count(0)
+  ,  _gsa_system(0)
+#endif
+#endif
+#ifndef _GPS_NO_CALLBACKS
+  ,  _on_fix()
+  ,  _on_time()
+  ,  _on_satellites()
+#endif
+#ifndef _GPS_NO_STATS
+  ,  _sentence_length(0)
+  ,  _filtered(false)
+  ,  _stats()
+#endif
+{
+  _fix.time = GPS_INVALID_TIME;
+  _fix.date = GPS_INVALID_DATE;
+  _fix.latitude = _fix.longitude = GPS_INVALID_ANGLE;
+  _fix.altitude = GPS_INVALID_ALTITUDE;
+#ifdef _GPS_HIGH_PRECISION
+  _fix.latitude_nano = _fix.longitude_nano = GPS_INVALID_ANGLE;
+  _fix.altitude_mm = GPS_INVALID_ALTITUDE;
+#endif
+  _fix.speed = GPS_INVALID_SPEED;
+#ifndef _GPS_NO_KINEMATICS
+  _fix.velocity.speed = GPS_INVALID_SPEED;
+  _fix.velocity.north = _fix.velocity.east = _fix.velocity.down = GPS_INVALID_SPEED;
+#endif
+  _fix.time_fix = _fix.position_fix = GPS_INVALID_FIX_TIME;
+#ifndef _GPS_NO_ZDA
+  _fix.date_fix = GPS_INVALID_FIX_TIME;
+  _fix.year = _fix.month = _fix.day = GPS_INVALID_DATE;
+#endif
+  _fix.course = _fix.hdop = 0xFFFF;
+  _fix.numsats = GPS_INVALID_SATELLITES;
+#ifndef _GPS_NO_EPOCH
+  _fix.utc.epoch = 0;
+  _fix.utc.year = 0;
+  _fix.utc.month = _fix.utc.day = 0;
+  _fix.utc.hour = _fix.utc.minute = _fix.utc.second = _fix.utc.hundredths = 0;
+#endif
+#ifdef _GPS_LAZY_DECODE
+  _fix.text.altitude[0] = _fix.text.course[0] = _fix.text.hdop[0] = 0;
+  _parsed.commits = _commits - 1;
+#endif
+  _new = _fix;
+}
+
+//
+// public methods
+//
+
+unsigned int TinyGPS::encode(const char *buf, size_t len)
+{
+#ifndef _GPS_NO_STATS
+  _stats.encoded_characters += len;
+#endif
+  return parse(buf, buf + len);
+}
+
+// encode() without the character count, for bytes parsed a second time
+unsigned int TinyGPS::parse(const char *buf, const char *end)
+{
+  unsigned int valid_sentences = 0;
+  while (buf < end)
+  {
+#ifndef _GPS_NO_UBX
+    if (_ubx_state)
+    {
+      buf = ubx_encode(buf, end, valid_sentences);
+      continue;
+    }
+#endif
+    // between sentences only a '$' or a UBX sync character matters
+    if (!_in_sentence)
+    {
+#ifndef _GPS_NO_STATS
+      const char *skip = buf;
+#endif
+#ifndef _GPS_NO_UBX
+      while (buf < end && *buf != '$' && (byte)*buf != _GPS_UBX_SYNC1)
+        ++buf;
+#else
+      buf = (const char *)memchr(buf, '$', end - buf);
+      if (!buf)
+        buf = end;
+#endif
+#ifndef _GPS_NO_STATS
+      if (_filtered)
+        _stats.skipped_characters += buf - skip;
+#endif
+      if (buf == end)
+        break;
+#ifndef _GPS_NO_UBX
+      if (*buf != '$')
+      {
+        _ubx_state = _GPS_UBX_SYNC;
+        ++buf;
+        continue;
+      }
+#endif
+    }
+
+    // ordinary characters: scan the whole run up to the next delimiter
+    const char *run = buf;
+    byte parity = 0;
+    buf = scan_run(buf, end, parity);
+    if (!_is_checksum_term)
+      _parity ^= parity;
+#ifndef _GPS_NO_STATS
+    _sentence_length += buf - run;
+#endif
+
+    // a term that continues past the end of this buffer is staged in _term
+    if (buf == end)
+    {
+      stage_term(run, buf - run);
+      break;
+    }
+
+    // a term contained in this buffer is parsed in place
+    const char *term = run;
+    size_t term_len = buf - run;
+    if (_term_offset)
+    {
+      stage_term(run, term_len);
+      term = _term;
+      term_len = _term_offset;
+    }
+
+    char c = *buf++;
+#ifndef _GPS_NO_STATS
+    ++_sentence_length;
+#endif
+    switch(c)
+    {
+    case ',': // term terminators
+      _parity ^= c;
+    case '\r':
+    case '\n':
+    case '*':
+      // every term is cut to the staging buffer's length, staged or not,
+      // so what it parses to does not depend on where the buffers split
+      if (term_len > sizeof(_term))
+      {
+#ifndef _GPS_NO_STATS
+        ++_stats.term_truncations;
+#endif
+        term_len = sizeof(_term);
+      }
+      if (term_complete(term, term_len))
+        ++valid_sentences;
+      ++_term_number;
+      _term_offset = 0;
+      _is_checksum_term = c == '*';
+      if (c == '\r' || c == '\n')
+        _in_sentence = false;
+      break;
+
+    case '$': // sentence begin
+      _in_sentence = true;
+      _sentence_time = now();
+      _term_number = _term_offset = 0;
+      _parity = 0;
+      _sentence_type = _GPS_SENTENCE_OTHER;
+      _is_checksum_term = false;
+      _gps_data_good = false;
+#ifndef _GPS_NO_STATS
+      _sentence_length = 1;
+      _filtered = false;
+#endif
+      break;
+    }
+  }
+
+  return valid_sentences;
+}
+
+#ifndef _GPS_NO_STATS
+// sentence counters are truncated to 16 bits, get_stats() has the full values
+void TinyGPS::stats(unsigned long *chars, unsigned short *sentences, unsigned short *failed_cs)
+{
+  if (chars) *chars = _stats.encoded_characters;
+  if (sentences) *sentences = _stats.good_sentences;
+  if (failed_cs) *failed_cs = _stats.failed_checksum;
+}
+
+void TinyGPS::get_stats(Stats &stats)
+{
+  stats = _stats;
+}
+#endif
+
+#ifndef _GPS_NO_GSV
+void TinyGPS::get_sky(Satellites &sky)
+{
+  byte generation;
+  do
+  {
+    while ((generation = _sky.generation()) & 1);
+    _GPS_BARRIER();
+    sky = _sky;
+    _GPS_BARRIER();
+  } while (generation != _sky.generation());
+}
+#endif
+
+//
+// internal utilities
+//
+
+// Returns the first delimiter in [p, end), or end, and XORs the characters
+// before it into parity. Every delimiter is <= ',', so whole blocks are
+// screened for such bytes and folded into the parity at once; the scalar
+// check only runs from the first candidate in a block.
+const char *TinyGPS::scan_run(const char *p, const char *end, byte &parity)
+{
+#if defined(_GPS_SCAN_SSE2)
+  const __m128i limit = _mm_set1_epi8(',');
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  bool folded = true; // most terms are shorter than a block
+  while (end - p >= 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(v, limit), zero));
+    if (mask)
+    {
+      for (const char *candidate = p + __builtin_ctz(mask); p < candidate; )
+        parity ^= *p++;
+      if (gpsisdelimiter(*p))
+        break;
+      parity ^= *p++;
+      continue;
+    }
+    acc = _mm_xor_si128(acc, v);
+    p += 16;
+    folded = false;
+  }
+  if (!folded)
+  {
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+    parity ^= (byte)_mm_cvtsi128_si32(acc);
+  }
+#elif defined(_GPS_SCAN_NEON)
+  const uint8x16_t limit = vdupq_n_u8(',');
+  uint8x16_t acc = vdupq_n_u8(0);
+  bool folded = true; // most terms are shorter than a block
+  while (end - p >= 16)
+  {
+    uint8x16_t v = vld1q_u8((const uint8_t *)p);
+    // narrow the 0x00/0xFF compare result to 4 bits per character
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(vcleq_u8(v, limit)), 4);
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+    if (mask)
+    {
+      for (const char *candidate = p + (__builtin_ctzll(mask) >> 2); p < candidate; )
+        parity ^= *p++;
+      if (gpsisdelimiter(*p))
+        break;
+      parity ^= *p++;
+      continue;
+    }
+    acc = veorq_u8(acc, v);
+    p += 16;
+    folded = false;
+  }
+  if (!folded)
+  {
+    uint64x2_t halves = vreinterpretq_u64_u8(acc);
+    uint64_t x = vgetq_lane_u64(halves, 0) ^ vgetq_lane_u64(halves, 1);
+    x ^= x >> 32;
+    x ^= x >> 16;
+    x ^= x >> 8;
+    parity ^= (byte)x;
+  }
+#elif defined(_GPS_SCAN_SWAR)
+  uint32_t acc = 0;
+  while (end - p >= 4)
+  {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    // nonzero when some byte of w is below '-'
+    if ((w - 0x2D2D2D2DUL) & ~w & 0x80808080UL)
+    {
+      for (const char *word_end = p + 4; p < word_end; ++p)
+      {
+        if (gpsisdelimiter(*p))
+          goto done;
+        parity ^= *p;
+      }
+      continue;
+    }
+    acc ^= w;
+    p += 4;
+  }
+done:
+  acc ^= acc >> 16;
+  acc ^= acc >> 8;
+  parity ^= (byte)acc;
+#endif
+  while (p < end && !gpsisdelimiter(*p))
+    parity ^= *p++;
+  return p;
+}
+
+#ifdef _GPS_LAZY_DECODE
+// Keeps a term for later conversion, false if it is too long to keep
+/* static */
+bool TinyGPS::defer_term(char *text, byte size, const char *term, byte len)
+{
+  if (len >= size)
+  {
+    text[0] = 0;
+    return false;
+  }
+  memcpy(text, term, len);
+  text[len] = 0;
+  return true;
+}
+
+void TinyGPS::parse_deferred(const Deferred &text, long &altitude, uint16_t &course, uint16_t &hdop)
+{
+  if (text.altitude[0])
+    altitude = parse_decimal(text.altitude, text.altitude + strlen(text.altitude));
+  if (text.course[0])
+    course = clamp16(parse_decimal(text.course, text.course + strlen(text.course)));
+  if (text.hdop[0])
+    hdop = clamp16(parse_decimal(text.hdop, text.hdop + strlen(text.hdop)));
+}
+
+// Converts the committed fix's deferred terms, once per commit: the text
+// is copied out under the sequence lock and parsed outside it. The result
+// is memoized in _parsed under a sequence count of its own, which a reader
+// in an interrupt handler checks like any other: it neither reads a memo
+// that is half written nor stores its own over one
+TinyGPS::Parsed TinyGPS::read_parsed()
+{
+  Parsed memo, parsed;
+  Deferred text;
+  byte memo_seq = _parsed_seq;
+  _GPS_BARRIER();
+  memo = _parsed;
+  _GPS_BARRIER();
+  bool memo_good = !(memo_seq & 1) && memo_seq == _parsed_seq;
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    parsed.commits = _commits;
+    if (!memo_good || parsed.commits != memo.commits)
+    {
+      parsed.altitude = _fix.altitude;
+      parsed.course = _fix.course;
+      parsed.hdop = _fix.hdop;
+      text = _fix.text;
+    }
+  } while (read_retry(seq));
+  if (memo_good && parsed.commits == memo.commits)
+    return memo;
+  parse_deferred(text, parsed.altitude, parsed.course, parsed.hdop);
+  if (!(_parsed_seq & 1))
+  {
+    ++_parsed_seq;
+    _GPS_BARRIER();
+    _parsed = parsed;
+    _GPS_BARRIER();
+    ++_parsed_seq;
+  }
+  return parsed;
+}
+#endif
+
+// _term keeps what fits of the term and _term_offset counts all of it, up
+// to 255, so that encode() truncates it as it would an unstaged term
+void TinyGPS::stage_term(const char *str, size_t len)
+{
+  if (_term_offset < sizeof(_term))
+    memcpy(_term + _term_offset, str, len < sizeof(_term) - _term_offset ? len : sizeof(_term) - _term_offset);
+  _term_offset = len < 0xFFU - _term_offset ? _term_offset + len : 0xFF;
+}
+
+// A position needs both coordinates and a ZDA date all three of its terms:
+// a sentence carrying only part of one leaves the committed value alone, so
+// what a sentence commits never depends on the sentences before it
+void TinyGPS::settle_changed()
+{
+  const uint16_t position = GPS_CHANGED_POSITION | _GPS_CHANGED_LONGITUDE;
+  if ((_changed & position) && (_changed & position) != position)
+  {
+    _new.latitude = _fix.latitude;
+    _new.longitude = _fix.longitude;
+#ifdef _GPS_HIGH_PRECISION
+    _new.latitude_nano = _fix.latitude_nano;
+    _new.longitude_nano = _fix.longitude_nano;
+#endif
+    _new.position_fix = _fix.position_fix;
+    _changed &= ~position;
+  }
+#ifndef _GPS_NO_ZDA
+  const uint16_t ymd = GPS_CHANGED_YMD | _GPS_CHANGED_MONTH | _GPS_CHANGED_YEAR;
+  if ((_changed & ymd) && (_changed & ymd) != ymd)
+  {
+    _new.year = _fix.year;
+    _new.month = _fix.month;
+    _new.day = _fix.day;
+    _new.date_fix = _fix.date_fix;
+    _changed &= ~ymd;
+  }
+#endif
+  _changed &= ~(_GPS_CHANGED_LONGITUDE | _GPS_CHANGED_MONTH | _GPS_CHANGED_YEAR);
+}
+
+#ifndef _GPS_NO_EPOCH
+// The RMC date's century comes from the last ZDA year, or the pivot before
+// one is seen. The epoch adds the time to a cached midnight, so only a
+// change of date costs any calendar arithmetic.
+void TinyGPS::settle_datetime()
+{
+  if (!(_changed & (GPS_CHANGED_TIME | GPS_CHANGED_DATE | GPS_CHANGED_YMD)))
+    return;
+  DateTime &utc = _new.utc;
+#ifndef _GPS_NO_ZDA
+  if (_changed & GPS_CHANGED_YMD)
+  {
+    utc.year = _new.year;
+    utc.month = _new.month;
+    utc.day = _new.day;
+  }
+  else
+#endif
+  if (_date_year != 0xFF)
+  {
+    utc.year = _date_year + (_date_year < _GPS_CENTURY_PIVOT ? 2000 : 1900);
+#ifndef _GPS_NO_ZDA
+    if (_new.year)
+    {
+      // the year nearest the ZDA one
+      unsigned int year = _new.year - _new.year % 100 + _date_year;
+      if (year > _new.year + 50)
+        year -= 100;
+      else if (year + 50 < _new.year)
+        year += 100;
+      utc.year = year;
+    }
+#endif
+  }
+
+  unsigned long date = ((unsigned long)utc.year << 16) | ((unsigned int)utc.month << 8) | utc.day;
+  if (date != _epoch_date)
+  {
+    _epoch_date = date;
+    _epoch_day = epoch_seconds(utc.year, utc.month, utc.day);
+  }
+  utc.epoch = _epoch_day && _new.time != GPS_INVALID_TIME ?
+    _epoch_day + utc.hour * 3600UL + utc.minute * 60U + utc.second : 0;
+}
+#endif
+
+#ifndef _GPS_NO_GSV
+// A GSV sequence is published whole: each validated message appends its
+// rows to the staged sequence, and the last one replaces the
+// constellation's satellites at once. A missing or out of order message,
+// or another talker's GSV, abandons the sequence. A GSA sentence sets the
+// used flags; the talker gives the constellation except for GNGSA, which
+// carries an NMEA 4.10 system ID or else is told apart by PRN.
+// GPS_CHANGED_SKY is only set when sky() actually changed.
+void TinyGPS::settle_sky()
+{
+#ifndef _GPS_NO_UBX
+  // a NAV-SAT message lists every constellation at once
+  if (_sentence_type == _GPS_SENTENCE_UBX)
+  {
+    if (_sky.assign(_gsv_rows, _gsv_staged))
+      _changed |= GPS_CHANGED_SKY;
+    _gsv_staged = 0;
+    return;
+  }
+#endif
+  byte constellation = _talker;
+  if (_sentence_type == _GPS_SENTENCE_GSV)
+  {
+    if (_gsv_message == 1)
+    {
+      _gsv_constellation = constellation;
+      _gsv_next = 1;
+    }
+    if (!_gsv_next || _gsv_message != _gsv_next || constellation != _gsv_constellation)
+    {
+      _gsv_next = 0;
+      return;
+    }
+
+    // a satellite's four terms all precede the checksum
+    byte rows = _term_number < 8 ? 0 : (_term_number - 4) / 4;
+    if (rows > 4)
+      rows = 4;
+    if (rows > _GPS_MAX_SATELLITES - _gsv_base)
+      rows = _GPS_MAX_SATELLITES - _gsv_base;
+    _gsv_staged = _gsv_base;
+    for (byte k = 0; k < rows; ++k)
+      if (_gsv_rows[_gsv_base + k].prn)
+        _gsv_rows[_gsv_staged++] = _gsv_rows[_gsv_base + k];
+
+    if (_gsv_message == _gsv_total)
+    {
+      if (_sky.replace(constellation, _gsv_rows, _gsv_staged))
+        _changed |= GPS_CHANGED_SKY;
+      _gsv_next = 0;
+    }
+    else
+      ++_gsv_next;
+  }
+#ifndef _GPS_NO_GSA
+  else
+  {
+    if (constellation == _GPS_TALKER_GN)
+    {
+      if (_gsa_system >= 1 && _gsa_system <= 5)
+        constellation = _gsa_system - 1;
+      else
+        constellation = _gsa_count && _gsa_prns[0] >= 65 && _gsa_prns[0] <= 96 ?
+          _GPS_TALKER_GL : _GPS_TALKER_GP;
+    }
+    if (_sky.set_used(constellation, _gsa_prns, _gsa_count))
+      _changed |= GPS_CHANGED_SKY;
+  }
+#endif
+}
+#endif
+
+// Commits a sentence or UBX frame whose checksum passed
+bool TinyGPS::commit_sentence()
+{
+  settle_changed();
+#ifdef _GPS_MERGE_EPOCHS
+  // a sentence of another time ends the epoch being merged
+  if (_held_changed && (_changed & GPS_CHANGED_TIME) && _new.time != _held.time)
+    publish_epoch();
+#endif
+#ifndef _GPS_NO_EPOCH
+  settle_datetime();
+#endif
+#ifndef _GPS_NO_STATS
+  ++_stats.passed_checksum;
+  ++_stats.accepted[_sentence_type];
+  if (!_gps_data_good && (_changed & GPS_CHANGED_POSITION))
+    ++_stats.no_fix;
+#endif
+  // _new only differs from _fix in the fields this sentence carried,
+  // so a validated sentence commits with a single struct copy
+  if (_gps_data_good)
+  {
 #ifndef _GPS_NO_STATS
-  ,  _encoded_characters(0)
-  ,  _good_sentences(0)
-  ,  _failed_checksum(0)
+    ++_stats.good_sentences;
+#endif
+#ifndef _GPS_NO_KINEMATICS
+    settle_kinematics();
+#endif
+#ifdef _GPS_MERGE_EPOCHS
+    if (_held_changed || (_changed & GPS_CHANGED_TIME))
+    {
+      hold_epoch();
+      return true;
+    }
+#endif
+    commit_begin();
+    _fix = _new;
+    commit_end();
+#ifndef _GPS_NO_CALLBACKS
+    notify(_on_fix, _changed);
+    notify(_on_time, _changed & (GPS_CHANGED_TIME | GPS_CHANGED_DATE));
+#endif
+    return true;
+  }
+
+  // Date and Time information: ZDA with full year info, or NAV-TIMEUTC
+  bool datetime = false;
+#ifndef _GPS_NO_ZDA
+  datetime = _sentence_type == _GPS_SENTENCE_ZDA;
+#endif
+#ifndef _GPS_NO_UBX
+  datetime = datetime || (_sentence_type == _GPS_SENTENCE_UBX && _ubx_message == _GPS_UBX_NAV_TIMEUTC);
+#endif
+  if (datetime)
+  {
+#ifdef _GPS_MERGE_EPOCHS
+    if (_held_changed)
+      hold_datetime();
+    else
+#endif
+    {
+      commit_begin();
+      _fix = _new;
+      commit_end();
+#ifndef _GPS_NO_CALLBACKS
+      notify(_on_time, _changed);
+#endif
+    }
+  }
+
+#ifndef _GPS_NO_GSV
+  if (_sentence_type == _GPS_SENTENCE_GSV || _sentence_type == _GPS_SENTENCE_GSA
+#ifndef _GPS_NO_UBX
+    || (_sentence_type == _GPS_SENTENCE_UBX && _ubx_message == _GPS_UBX_NAV_SAT)
+#endif
+    )
+  {
+    settle_sky();
+#ifndef _GPS_NO_CALLBACKS
+    if (_changed & GPS_CHANGED_SKY)
+      notify(_on_satellites, _changed);
+#endif
+  }
+#endif
+
+  //set the time and date even if not tracking
+  if (_sentence_type == _GPS_SENTENCE_RMC
+#ifndef _GPS_NO_PUBX
+    || ((_sentence_type == _GPS_SENTENCE_PUBX) && (_UBX_message_type == 4))   // UBX,04 Time of Day and Clock Information
+#endif
+#ifndef _GPS_NO_UBX
+    || (_sentence_type == _GPS_SENTENCE_UBX && _ubx_message == _GPS_UBX_NAV_PVT)
+#endif
+   )
+  {
+#ifdef _GPS_MERGE_EPOCHS
+    // the epoch of this time is still held: publish them together
+    if (_held_changed)
+    {
+      hold_datetime();
+      return false;
+    }
+#endif
+    commit_begin();
+    _fix.time     = _new.time;
+    _fix.date     = _new.date;
+    _fix.time_fix = _new.time_fix;
+#ifndef _GPS_NO_ZDA
+    if (_changed & GPS_CHANGED_YMD)
+    {
+      _fix.year     = _new.year;
+      _fix.month    = _new.month;
+      _fix.day      = _new.day;
+      _fix.date_fix = _new.date_fix;
+    }
+#endif
+#ifndef _GPS_NO_EPOCH
+    _fix.utc      = _new.utc;
+#endif
+    commit_end();
+#ifndef _GPS_NO_CALLBACKS
+    notify(_on_time, _changed & (GPS_CHANGED_TIME | GPS_CHANGED_DATE | GPS_CHANGED_YMD));
+#endif
+  }
+  return false;
+}
+
+#ifdef _GPS_MERGE_EPOCHS
+// fix quality rank of GGA quality indicators 0..8: RTK fixed, RTK float,
+// differential, autonomous, then estimated, manual and simulated
+static const byte _gps_gga_rank[] PROGMEM = { 0, 2, 3, 3, 5, 4, 1, 1, 1 };
+
+// Ranks the source of the current sentence's position by fix quality,
+// then lower HDOP, then more satellites, as far as the sentence carried them
+unsigned long TinyGPS::source_score()
+{
+  uint16_t hdop = 0xFFFF;
+  if (_changed & GPS_CHANGED_HDOP)
+  {
+    hdop = _new.hdop;
+#ifdef _GPS_LAZY_DECODE
+    if (_new.text.hdop[0])
+      hdop = clamp16(parse_decimal(_new.text.hdop, _new.text.hdop + strlen(_new.text.hdop)));
+#endif
+  }
+  byte sats = (_changed & GPS_CHANGED_SATELLITES) && _new.numsats != GPS_INVALID_SATELLITES ? _new.numsats : 0;
+  return (unsigned long)_quality << 24 | (unsigned long)(0xFFFF - hdop) << 8 | sats;
+}
+
+// Merges a validated sentence into the epoch. The first sentence of an
+// epoch starts it and later ones add the fields it lacks. A sentence whose
+// position has the better source replaces every field it carried, and a
+// tie keeps the first, so the committed position does not alternate
+// between talkers from one epoch to the next.
+void TinyGPS::hold_epoch()
+{
+  unsigned long score = (_changed & GPS_CHANGED_POSITION) ? source_score() : 0;
+  if (!_held_changed)
+  {
+    _held = _new;
+    _held_changed = _changed;
+    _held_score = score;
+    return;
+  }
+  uint16_t take = _changed & ~_held_changed;
+  if (score > _held_score)
+  {
+    take = _changed;
+    _held_score = score;
+  }
+  copy_fields(take, _new, _held);
+  _held_changed |= _changed;
+}
+
+// Merges only the time and date of a sentence without a fix into the
+// epoch, so they are published with it and not beside the last epoch's
+// position; its other fields are not a fix and are left out
+void TinyGPS::hold_datetime()
+{
+  uint16_t changed = _changed;
+  _changed &= GPS_CHANGED_TIME | GPS_CHANGED_DATE | GPS_CHANGED_YMD;
+  if (_changed)
+    hold_epoch();
+  _changed = changed;
+}
+
+// Commits the epoch as one fix, with one on_fix() for all its sentences
+void TinyGPS::publish_epoch()
+{
+  uint16_t changed = _held_changed;
+  _held_changed = 0;
+  // the sentence being parsed was seeded from _fix before the epoch was in it
+  copy_fields(changed & ~_changed, _held, _new);
+  commit_begin();
+  copy_fields(changed, _held, _fix);
+  commit_end();
+#ifndef _GPS_NO_CALLBACKS
+  notify(_on_fix, changed);
+  notify(_on_time, changed & (GPS_CHANGED_TIME | GPS_CHANGED_DATE));
+#endif
+}
+#endif
+
+int TinyGPS::from_hex(char a) 
+{
+  if (a >= 'A' && a <= 'F')
+    return a - 'A' + 10;
+  else if (a >= 'a' && a <= 'f')
+    return a - 'a' + 10;
+  else
+    return a - '0';
+}
+
+// 10^i, i = 0..9
+static const uint32_t _gps_pow10[] PROGMEM = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL,
+  100000000UL, 1000000000UL
+};
+
+// Parses a signed decimal in one pass into units of 10^-decimals,
+// decimals <= 9, dropping any further digits
+unsigned long TinyGPS::parse_decimal(const char *p, const char *end, byte decimals)
+{
+  bool isneg = p < end && *p == '-';
+  if (isneg) ++p;
+  unsigned long ret = 0;
+  for (; p < end && gpsisdigit(*p); ++p)
+    ret = 10 * ret + (*p - '0');
+  byte n = 0;
+  if (p < end && *p == '.')
+    for (++p; n < decimals && p < end && gpsisdigit(*p); ++p, ++n)
+      ret = 10 * ret + (*p - '0');
+  ret *= pgm_read_dword(&_gps_pow10[decimals - n]);
+  return isneg ? -ret : ret;
+}
+
+// Parse a string in the form ddmm.mmmmmmm... in one pass: the integer
+// digits shift through a two digit window that ends up holding the
+// minutes, and the fraction keeps five decimals of a minute (nine for
+// nano), so a single division is left
+#ifndef _GPS_HIGH_PRECISION
+unsigned long TinyGPS::parse_degrees(const char *p, const char *end)
+#else
+unsigned long TinyGPS::parse_degrees(const char *p, const char *end, int64_t &nano)
+#endif
+{
+  unsigned long degrees = 0;
+  byte tens = 0, units = 0;
+  for (; p < end && gpsisdigit(*p); ++p)
+  {
+    degrees = 10 * degrees + tens;
+    tens = units;
+    units = *p - '0';
+  }
+  unsigned long minutes = 10 * tens + units;
+  unsigned long fraction = 0; // 100000ths of a minute
+  byte n = 0;
+#ifndef _GPS_HIGH_PRECISION
+  if (p < end && *p == '.')
+    for (++p; n < 5 && p < end && gpsisdigit(*p); ++p, ++n)
+      fraction = 10 * fraction + (*p - '0');
+  fraction *= pgm_read_dword(&_gps_pow10[5 - n]);
+#else
+  unsigned long fine = 0; // 10^9ths of a minute
+  if (p < end && *p == '.')
+    for (++p; n < 9 && p < end && gpsisdigit(*p); ++p, ++n)
+    {
+      if (n < 5)
+        fraction = 10 * fraction + (*p - '0');
+      fine = 10 * fine + (*p - '0');
+    }
+  fraction *= pgm_read_dword(&_gps_pow10[n < 5 ? 5 - n : 0]);
+  fine *= pgm_read_dword(&_gps_pow10[9 - n]);
+  nano = (int64_t)((uint64_t)degrees * 1000000000 + ((uint64_t)minutes * 1000000000 + fine + 30) / 60);
+#endif
+  return degrees * 1000000 + (minutes * 100000 + fraction + 3) / 6;
+}
+
+// Resolves term 0 to a sentence type: the talker and the formatter are each
+// packed into an integer and dispatched with a single switch, so any talker
+// (GP, GL, GA, GB, GQ, GN) costs the same as any other
+byte TinyGPS::resolve_sentence_type(const char *term, byte len)
+{
+#ifndef _GPS_NO_PUBX
+  if (len == 4 && term[0] == 'P' && term[1] == 'U' && term[2] == 'B' && term[3] == 'X')
+    return _GPS_SENTENCE_PUBX;
+#endif
+  if (len != 5)
+    return _GPS_SENTENCE_OTHER;
+  for (byte i=0; i<5; ++i)
+    if (term[i] < 'A' || term[i] > 'Z')
+      return _GPS_SENTENCE_OTHER;
+
+  switch (_GPS_PACK2(term[0], term[1]))
+  {
+  case _GPS_PACK2('G', 'P'): _talker = _GPS_TALKER_GP; break;
+  case _GPS_PACK2('G', 'L'): _talker = _GPS_TALKER_GL; break;
+  case _GPS_PACK2('G', 'A'): _talker = _GPS_TALKER_GA; break;
+  case _GPS_PACK2('G', 'B'):
+  case _GPS_PACK2('B', 'D'): _talker = _GPS_TALKER_GB; break;
+  case _GPS_PACK2('G', 'Q'): _talker = _GPS_TALKER_GQ; break;
+  case _GPS_PACK2('G', 'N'): _talker = _GPS_TALKER_GN; break;
+  default: return _GPS_SENTENCE_OTHER;
+  }
+
+  switch (_GPS_PACK3(term[2], term[3], term[4]))
+  {
+  case _GPS_PACK3('R', 'M', 'C'): return _GPS_SENTENCE_RMC;
+  case _GPS_PACK3('G', 'G', 'A'): return _GPS_SENTENCE_GGA;
+#ifndef _GPS_NO_GNS
+  case _GPS_PACK3('G', 'N', 'S'): return _GPS_SENTENCE_GNS;
+#endif
+#ifndef _GPS_NO_GSA
+  case _GPS_PACK3('G', 'S', 'A'): return _GPS_SENTENCE_GSA;
+#endif
+#ifndef _GPS_NO_ZDA
+  case _GPS_PACK3('Z', 'D', 'A'): return _GPS_SENTENCE_ZDA;
+#endif
+#ifndef _GPS_NO_VTG
+  case _GPS_PACK3('V', 'T', 'G'): return _GPS_SENTENCE_VTG;
+#endif
+#ifndef _GPS_NO_GSV
+  case _GPS_PACK3('G', 'S', 'V'): return _GPS_SENTENCE_GSV;
+#endif
+  }
+  return _GPS_SENTENCE_OTHER;
+}
+
+// Processes a just-completed term of len characters (not NUL terminated)
+// Returns true if new sentence has just passed checksum test and is validated
+bool TinyGPS::term_complete(const char *term, byte len)
+{
+  const char *end = term + len;
+
+  if (_is_checksum_term)
+  {
+    byte checksum = len < 2 ? ~_parity : 16 * from_hex(term[0]) + from_hex(term[1]);
+#ifndef _GPS_NO_STATS
+    if (_sentence_length > _stats.max_sentence_length)
+      _stats.max_sentence_length = _sentence_length;
+#endif
+    if (checksum == _parity)
+      return commit_sentence();
+#ifndef _GPS_NO_STATS
+    else
+    {
+      ++_stats.failed_checksum;
+      ++_stats.rejected[_sentence_type];
+    }
+#endif
+    return false;
+  }
+
+  // the first term determines the sentence type
+  if (_term_number == 0)
+  {
+    _sentence_type = resolve_sentence_type(term, len);
+    if (!(_sentence_filter & (1U << _sentence_type)))
+    {
+      _in_sentence = false;
+#ifndef _GPS_NO_STATS
+      _filtered = true;
+#endif
+      return false;
+    }
+    _field = _gps_sentence_fields[_sentence_type];
+    _new = _fix;
+    _changed = 0;
+#ifdef _GPS_MERGE_EPOCHS
+    _quality = 2;
+#endif
+#ifndef _GPS_NO_EPOCH
+    _date_year = 0xFF;
+#endif
+#ifndef _GPS_NO_GSV
+    if (_sentence_type == _GPS_SENTENCE_GSV)
+    {
+      _gsv_total = _gsv_message = 0;
+      _gsv_base = _GPS_MAX_SATELLITES;
+    }
+#ifndef _GPS_NO_GSA
+    _gsa_count = _gsa_system = 0;
+#endif
+#endif
+#ifndef _GPS_NO_VTG
+    // a VTG is a fix unless its mode says otherwise, and before NMEA 2.3
+    // it has no mode term
+    if (_sentence_type == _GPS_SENTENCE_VTG)
+      _gps_data_good = true;
+#endif
+    return false;
+  }
+
+  // advance through the schema to the descriptor for this term
+  byte field_term;
+  while ((field_term = pgm_read_byte(&_field->term)) < _term_number &&
+      pgm_read_byte(&_field->kind) != _GPS_FIELD_GSV_SATELLITES)
+    ++_field;
+  if (field_term > _term_number || !len)
+    return false;
+
+  switch(pgm_read_byte(&_field->kind))
+  {
+  case _GPS_FIELD_TIME:
+  {
+    // shorter than hhmmss, or not a time of day, is unreadable rather than
+    // the time before it, for get_datetime(), crack_datetime() and epoch() alike
+    byte hour = 0xFF, minute = 0xFF, second = 0xFF;
+    if (len >= 6)
+    {
+      hour = _gps_two_digits(term);
+      minute = _gps_two_digits(term + 2);
+      second = _gps_two_digits(term + 4);
+    }
+    bool readable = hour < 24 && minute < 60 && second < 61;
+    _new.time = readable ? parse_decimal(term, end) : (unsigned long)GPS_INVALID_TIME;
+    _new.time_fix = _sentence_time;
+    _changed |= GPS_CHANGED_TIME;
+#ifndef _GPS_NO_EPOCH
+    if (readable)
+    {
+      _new.utc.hour = hour;
+      _new.utc.minute = minute;
+      _new.utc.second = second;
+      _new.utc.hundredths = 0;
+      if (len >= 8 && term[6] == '.' && gpsisdigit(term[7]))
+        _new.utc.hundredths = len >= 9 && gpsisdigit(term[8]) ? _gps_two_digits(term + 7) : 10 * (term[7] - '0');
+    }
+    else
+      _new.utc.hour = _new.utc.minute = _new.utc.second = _new.utc.hundredths = 0;
+#endif
+    break;
+  }
+  case _GPS_FIELD_RMC_STATUS:
+    _gps_data_good = term[0] == 'A';
+    break;
+  case _GPS_FIELD_LATITUDE:
+#ifndef _GPS_HIGH_PRECISION
+    _new.latitude = parse_degrees(term, end);
+#else
+    _new.latitude = parse_degrees(term, end, _new.latitude_nano);
+#endif
+    _new.position_fix = _sentence_time;
+    _changed |= GPS_CHANGED_POSITION;
+    break;
+  case _GPS_FIELD_NS:
+    if (term[0] == 'S' && (_changed & GPS_CHANGED_POSITION))
+    {
+      _new.latitude = -_new.latitude;
+#ifdef _GPS_HIGH_PRECISION
+      _new.latitude_nano = -_new.latitude_nano;
+#endif
+    }
+    break;
+  case _GPS_FIELD_LONGITUDE:
+#ifndef _GPS_HIGH_PRECISION
+    _new.longitude = parse_degrees(term, end);
+#else
+    _new.longitude = parse_degrees(term, end, _new.longitude_nano);
+#endif
+    _changed |= _GPS_CHANGED_LONGITUDE;
+    break;
+  case _GPS_FIELD_EW:
+    if (term[0] == 'W' && (_changed & _GPS_CHANGED_LONGITUDE))
+    {
+      _new.longitude = -_new.longitude;
+#ifdef _GPS_HIGH_PRECISION
+      _new.longitude_nano = -_new.longitude_nano;
+#endif
+    }
+    break;
+#ifndef _GPS_NO_GNS
+  case _GPS_FIELD_CONSTELLATIONS:
+  {
+    byte n = len < sizeof(_constellations) - 1 ? len : sizeof(_constellations) - 1;
+    memcpy(_constellations, term, n);
+    _constellations[n] = 0;
+    break;
+  }
+#endif
+  case _GPS_FIELD_SPEED:
+    _new.speed = parse_decimal(term, end);
+    _changed |= GPS_CHANGED_SPEED;
+    break;
+  case _GPS_FIELD_SPEED_KMH: // 100ths of a km/h to 100ths of a knot
+    _new.speed = (parse_decimal(term, end) * 1000 + 926) / 1852;
+    _changed |= GPS_CHANGED_SPEED;
+    break;
+#ifndef _GPS_NO_KINEMATICS
+  case _GPS_FIELD_VERTICAL_SPEED: // m/s, positive down
+    _new.velocity.down = parse_decimal(term, end, 3);
+    _changed |= GPS_CHANGED_VERTICAL;
+    break;
+#endif
+#ifndef _GPS_NO_VTG
+  case _GPS_FIELD_VTG_MODE: // NMEA 2.3 mode indicator, N when not valid
+    if (term[0] == 'N')
+      _gps_data_good = false;
+    break;
+#endif
+  case _GPS_FIELD_COURSE:
+    _changed |= GPS_CHANGED_COURSE;
+#ifdef _GPS_LAZY_DECODE
+    if (defer_term(_new.text.course, sizeof(_new.text.course), term, len))
+      break;
+#endif
+    _new.course = clamp16(parse_decimal(term, end));
+    break;
+  case _GPS_FIELD_DATE:
+  {
+    // as the time: shorter than ddmmyy, or not a date, is unreadable
+    byte day = 0xFF, month = 0xFF, year = 0xFF;
+    if (len >= 6)
+    {
+      day = _gps_two_digits(term);
+      month = _gps_two_digits(term + 2);
+      year = _gps_two_digits(term + 4);
+    }
+    bool readable = day >= 1 && day <= 31 && month >= 1 && month <= 12 && year < 100;
+    _new.date = readable ? gpsatol(term, end) : (unsigned long)GPS_INVALID_DATE;
+    _changed |= GPS_CHANGED_DATE;
+#ifndef _GPS_NO_EPOCH
+    if (readable)
+    {
+      _new.utc.day = day;
+      _new.utc.month = month;
+      _date_year = year;
+    }
+    else // unreadable, rather than the date before it
+    {
+      _new.utc.year = 0;
+      _new.utc.month = _new.utc.day = 0;
+    }
+#endif
+    break;
+  }
+#ifndef _GPS_NO_ZDA
+  case _GPS_FIELD_DAY:
+    _new.day = gpsatol(term, end);
+    _new.date_fix = _sentence_time;
+    _changed |= GPS_CHANGED_YMD;
+    break;
+  case _GPS_FIELD_MONTH:
+    _new.month = gpsatol(term, end);
+    _new.date_fix = _sentence_time;
+    _changed |= _GPS_CHANGED_MONTH;
+    break;
+  case _GPS_FIELD_YEAR:
+    _new.year = gpsatol(term, end);
+    _new.date_fix = _sentence_time;
+    _changed |= _GPS_CHANGED_YEAR;
+    break;
+#endif
+  case _GPS_FIELD_GGA_QUALITY:
+    _gps_data_good = term[0] > '0';
+#ifdef _GPS_MERGE_EPOCHS
+    _quality = term[0] <= '8' && _gps_data_good ? pgm_read_byte(&_gps_gga_rank[term[0] - '0']) : 1;
+#endif
+    break;
+  case _GPS_FIELD_NUMSATS: // GGA: GPS only, GNS counts-in all constellations
+    _new.numsats = (byte)gpsatol(term, end);
+    _changed |= GPS_CHANGED_SATELLITES;
+    break;
+  case _GPS_FIELD_HDOP:
+    _changed |= GPS_CHANGED_HDOP;
+#ifdef _GPS_LAZY_DECODE
+    if (defer_term(_new.text.hdop, sizeof(_new.text.hdop), term, len))
+      break;
+#endif
+    _new.hdop = clamp16(parse_decimal(term, end));
+    break;
+  case _GPS_FIELD_ALTITUDE:
+    _changed |= GPS_CHANGED_ALTITUDE;
+#ifdef _GPS_HIGH_PRECISION
+    _new.altitude_mm = parse_decimal(term, end, 3);
+#endif
+#ifdef _GPS_LAZY_DECODE
+    if (defer_term(_new.text.altitude, sizeof(_new.text.altitude), term, len))
+      break;
+#endif
+    _new.altitude = parse_decimal(term, end);
+    break;
+#ifndef _GPS_NO_PUBX
+  case _GPS_FIELD_UBX_MESSAGE:
+    // PUBX messages, use 1st term to determine the message content
+    _UBX_message_type = gpsatol(term, end);
+#ifdef DEBUG
+    Serial.print("_GPS_SENTENCE_PUBX "); Serial.println(_UBX_message_type);
+#endif
+    _field = _UBX_message_type == 0 ? _gps_fields_pubx00 :
+      _UBX_message_type == 4 ? _gps_fields_pubx04 : _gps_fields_none;
+    break;
+  case _GPS_FIELD_UBX_NAVSTAT:
+    // Checking Navigation Status - ok if G2, G3, D2, D3 not ok on NF, DR, RK, or TT
+#ifdef DEBUG
+    Serial.print("NavStat: "); Serial.write(term, len); Serial.println();
+#endif
+    _gps_data_good = (term[0] == 'G' || (term[0] == 'D' && (len < 2 || term[1] != 'R')));
+#ifdef _GPS_MERGE_EPOCHS
+    _quality = term[0] == 'D' ? 3 : 2;
+#endif
+    break;
+#endif
+#ifndef _GPS_NO_GSV
+#ifndef _GPS_NO_GSA
+  case _GPS_FIELD_GSA_PRN:
+  {
+    long prn = gpsatol(term, end);
+    if (prn > 0 && prn <= 0xFF && _gsa_count < sizeof(_gsa_prns))
+      _gsa_prns[_gsa_count++] = prn;
+    break;
+  }
+  case _GPS_FIELD_GSA_SYSTEM:
+    _gsa_system = gpsatol(term, end);
+    break;
+#endif
+  case _GPS_FIELD_GSV_TOTAL:
+    _gsv_total = gpsatol(term, end);
+    break;
+  case _GPS_FIELD_GSV_MESSAGE:
+    _gsv_message = gpsatol(term, end);
+    // a first message abandons any sequence in progress
+    if (_gsv_message == 1)
+      _gsv_next = 0;
+    _gsv_base = _gsv_message == 1 ? 0 : _gsv_next ? _gsv_staged : _GPS_MAX_SATELLITES;
+    for (byte k = _gsv_base; k < _gsv_base + 4 && k < _GPS_MAX_SATELLITES; ++k)
+      _gsv_rows[k].prn = 0;
+    break;
+  case _GPS_FIELD_GSV_SATELLITES:
+  {
+    byte row = (_term_number - 4) / 4;
+    if (row < 4 && _gsv_base + row < _GPS_MAX_SATELLITES)
+    {
+      Satellites::Row &r = _gsv_rows[_gsv_base + row];
+      long v = gpsatol(term, end);
+      switch ((_term_number - 4) % 4)
+      {
+      case 0:
+        r.prn = v <= 0xFF ? v : 0;
+        r.elevation = r.snr = 0;
+        r.azimuth = 0;
+        break;
+      case 1: r.elevation = v; break;
+      case 2: r.azimuth = v; break;
+      case 3: r.snr = v; break;
+      }
+    }
+    break;
+  }
+#endif
+  }
+
+  return false;
+}
+
+long TinyGPS::gpsatol(const char *str, const char *end)
+{
+  // unsigned, so that too many digits wrap instead of overflowing
+  unsigned long ret = 0;
+  while (str < end && gpsisdigit(*str))
+    ret = 10 * ret + *str++ - '0';
+  return (long)ret;
+}
+
+#ifndef _GPS_NO_UBX
+//
+// UBX binary protocol: frames are decoded a byte at a time into _new, so
+// nothing but the few fields in use is buffered, and committed like NMEA
+// sentences once their checksum passes
+//
+
+// Consumes the bytes of a UBX frame from p, returns where the frame or the
+// buffer ended
+const char *TinyGPS::ubx_encode(const char *p, const char *end, unsigned int &valid_sentences)
+{
+  while (p < end && _ubx_state)
+  {
+    byte b = *p++;
+    if (_ubx_state >= _GPS_UBX_CLASS && _ubx_state <= _GPS_UBX_PAYLOAD)
+    {
+      _ubx_ck_a += b;
+      _ubx_ck_b += _ubx_ck_a;
+    }
+    switch (_ubx_state)
+    {
+    case _GPS_UBX_SYNC:
+      if (b == _GPS_UBX_SYNC2)
+      {
+        _ubx_ck_a = _ubx_ck_b = 0;
+        _ubx_state = _GPS_UBX_CLASS;
+      }
+      else
+      {
+        // not a frame after all, the byte may be a '$'
+        _ubx_state = _GPS_UBX_IDLE;
+        --p;
+      }
+      break;
+    case _GPS_UBX_CLASS:
+      _ubx_message = (uint16_t)b << 8;
+      _ubx_state = _GPS_UBX_ID;
+      break;
+    case _GPS_UBX_ID:
+      _ubx_message |= b;
+      _ubx_state = _GPS_UBX_LENGTH1;
+      break;
+    case _GPS_UBX_LENGTH1:
+      _ubx_length = b;
+      _ubx_state = _GPS_UBX_LENGTH2;
+      break;
+    case _GPS_UBX_LENGTH2:
+      _ubx_length |= (uint16_t)b << 8;
+      if (!ubx_length_ok())
+      {
+        // a stray sync, from line noise or a frame cut short, rather than a
+        // frame: rejected at once, not after up to 64K bytes of NMEA, and
+        // the header after it is parsed again as it would have been
+        _ubx_state = _GPS_UBX_IDLE;
+#ifndef _GPS_NO_STATS
+        ++_stats.failed_checksum;
+        ++_stats.rejected[_GPS_SENTENCE_UBX];
+#endif
+        const char header[4] = { (char)(_ubx_message >> 8), (char)_ubx_message,
+          (char)_ubx_length, (char)(_ubx_length >> 8) };
+        valid_sentences += parse(header, header + sizeof(header));
+        return p;
+      }
+      _ubx_offset = 0;
+      ubx_begin();
+      _ubx_state = _ubx_length ? _GPS_UBX_PAYLOAD : _GPS_UBX_CK_A;
+      break;
+    case _GPS_UBX_PAYLOAD:
+      ubx_payload(b);
+      if (++_ubx_offset == _ubx_length)
+        _ubx_state = _GPS_UBX_CK_A;
+      break;
+    case _GPS_UBX_CK_A:
+      _ubx_ck_a ^= b; // 0 if it matches
+      _ubx_state = _GPS_UBX_CK_B;
+      break;
+    case _GPS_UBX_CK_B:
+      _ubx_state = _GPS_UBX_IDLE;
+      if (!_ubx_ck_a && b == _ubx_ck_b)
+      {
+        if (ubx_complete())
+          ++valid_sentences;
+      }
+#ifndef _GPS_NO_STATS
+      else
+      {
+        ++_stats.failed_checksum;
+        ++_stats.rejected[_GPS_SENTENCE_UBX];
+      }
+#endif
+      break;
+    }
+  }
+  return p;
+}
+
+// whether a frame's header announces a payload it could carry: the exact
+// length of the messages decoded, and at most _GPS_UBX_MAX_LENGTH bytes
+bool TinyGPS::ubx_length_ok()
+{
+  switch (_ubx_message)
+  {
+  case _GPS_UBX_NAV_PVT: return _ubx_length == 92;
+  case _GPS_UBX_NAV_TIMEUTC: return _ubx_length == 20;
+  case _GPS_UBX_NAV_DOP: return _ubx_length == 18;
+  case _GPS_UBX_NAV_SAT: // 12 bytes per satellite after an 8 byte header
+    return _ubx_length >= 8 && (_ubx_length - 8) % 12 == 0 && _ubx_length <= _GPS_UBX_MAX_LENGTH;
+  }
+  return _ubx_length <= _GPS_UBX_MAX_LENGTH;
+}
+
+// A frame's header has arrived: seed _new as the first term of a sentence
+// does, for the messages decoded. Others are passed over and leave the
+// parser as it was, clock included. Frames only start between sentences,
+// so none is ever cut short.
+void TinyGPS::ubx_begin()
+{
+  switch (_ubx_message)
+  {
+  case _GPS_UBX_NAV_PVT:
+  case _GPS_UBX_NAV_TIMEUTC:
+  case _GPS_UBX_NAV_DOP:
+#ifndef _GPS_NO_GSV
+  case _GPS_UBX_NAV_SAT:
+#endif
+    break;
+  default:
+    return;
+  }
+  _sentence_type = _GPS_SENTENCE_UBX;
+  _sentence_time = now();
+  _new = _fix;
+  _changed = 0;
+#ifdef _GPS_MERGE_EPOCHS
+  _quality = 2;
+#endif
+  _gps_data_good = false;
+  _ubx_value = _ubx_date = _ubx_time = 0;
+  _ubx_nano = 0;
+#ifndef _GPS_NO_EPOCH
+  _date_year = 0xFF;
+#endif
+#ifndef _GPS_NO_GSV
+  if (_ubx_message == _GPS_UBX_NAV_SAT)
+  {
+    // the rows are staged where a GSV sequence would be, abandoning it
+    // even if this frame's checksum then fails
+    _gsv_next = _gsv_staged = 0;
+    _ubx_sat_byte = 0;
+  }
+#endif
+}
+
+#ifndef _GPS_NO_GSV
+// Maps a NAV-SAT gnssId and svId, in flags and prn, to the constellation
+// and PRN the NMEA sentences use, false for satellites they do not list
+static bool _gps_ubx_satellite(TinyGPS::Satellites::Row &r, bool used)
+{
+  byte constellation;
+  switch (r.flags)
+  {
+  case 0: constellation = TinyGPS::Satellites::GPS; break;
+  case 1: // SBAS, NMEA PRNs 33..64
+    if (r.prn < 120 || r.prn > 151)
+      return false;
+    r.prn -= 87;
+    constellation = TinyGPS::Satellites::GPS;
+    break;
+  case 2: constellation = TinyGPS::Satellites::GALILEO; break;
+  case 3: constellation = TinyGPS::Satellites::BEIDOU; break;
+  case 5: constellation = TinyGPS::Satellites::QZSS; break;
+  case 6: // GLONASS slots, NMEA PRNs 65..96
+    if (r.prn > 32)
+      return false;
+    r.prn += 64;
+    constellation = TinyGPS::Satellites::GLONASS;
+    break;
+  default:
+    return false;
+  }
+  r.flags = constellation | (used ? TinyGPS::Satellites::ROW_USED : 0);
+  return r.prn != 0;
+}
+#endif
+
+// Takes the payload byte at _ubx_offset. Each field is picked up at its
+// last byte, when _ubx_value holds it in its top bytes.
+void TinyGPS::ubx_payload(byte b)
+{
+  const unsigned long v = _ubx_value = (_ubx_value >> 8) | ((unsigned long)b << 24);
+  switch (_ubx_message)
+  {
+  case _GPS_UBX_NAV_PVT:
+    switch (_ubx_offset)
+    {
+    case 7: _ubx_date = v; break;
+    case 11: _ubx_time = v; break; // valid bit 0 is the date's, bit 1 the time's
+    case 19: _ubx_nano = (int32_t)v; break;
+    case 21: // a 2D, 3D or dead reckoning fixType with gnssFixOK
+      _gps_data_good = (v & 0x01000000UL) && (byte)(v >> 16) >= 2 && (byte)(v >> 16) <= 4;
+      break;
+    case 23: _new.numsats = v >> 24; break;
+#ifndef _GPS_HIGH_PRECISION
+    case 27: _new.longitude = (int32_t)v / 10; break;     // 1e-7 degrees
+    case 31: _new.latitude = (int32_t)v / 10; break;
+    case 39: _new.altitude = (int32_t)v / 10; break;      // hMSL, millimeters
+#else
+    case 27:
+      _new.longitude = (int32_t)v / 10;
+      _new.longitude_nano = (int64_t)(int32_t)v * 100;
+      break;
+    case 31:
+      _new.latitude = (int32_t)v / 10;
+      _new.latitude_nano = (int64_t)(int32_t)v * 100;
+      break;
+    case 39:
+      _new.altitude = (int32_t)v / 10;
+      _new.altitude_mm = (int32_t)v;
+      break;
+#endif
+#ifndef _GPS_NO_KINEMATICS
+    case 59: _new.velocity.down = (int32_t)v; break;     // velD, mm/s
+#endif
+    case 63: _new.speed = (v * 360 + 926) / 1852; break; // gSpeed, mm/s
+    case 67: _new.course = (v + 500) / 1000 % 36000; break; // headMot, 1e-5 degrees
+    }
+    break;
+  case _GPS_UBX_NAV_TIMEUTC:
+    switch (_ubx_offset)
+    {
+    case 11: _ubx_nano = (int32_t)v; break;
+    case 15: _ubx_date = v; break;
+    case 19: // validUTC stands for both of NAV-PVT's bits
+      _ubx_time = (v & 0xFFFFFFUL) | (v & 0x04000000UL ? 0x03000000UL : 0);
+      break;
+    }
+    break;
+  case _GPS_UBX_NAV_DOP:
+    if (_ubx_offset == 13)
+      _new.hdop = v >> 16;
+    break;
+#ifndef _GPS_NO_GSV
+  case _GPS_UBX_NAV_SAT:
+    if (_ubx_offset >= 8 && _gsv_staged < _GPS_MAX_SATELLITES)
+    {
+      // 12 bytes per satellite after an 8 byte header
+      Satellites::Row &r = _gsv_rows[_gsv_staged];
+      switch (_ubx_sat_byte)
+      {
+      case 0: r.flags = b; break; // gnssId until the row is complete
+      case 1: r.prn = b; break;
+      case 2: r.snr = b; break;
+      case 3: r.elevation = (signed char)b < 0 ? 0 : b; break;
+      case 5: r.azimuth = (v & 0x80000000UL) ? 0 : v >> 16; break;
+      case 8: // svUsed is bit 3 of the flags
+        if (_gps_ubx_satellite(r, b & 0x08))
+          ++_gsv_staged;
+        break;
+      }
+    }
+    if (_ubx_offset >= 8 && ++_ubx_sat_byte == 12)
+      _ubx_sat_byte = 0;
+    break;
+#endif
+  }
+}
+
+// NAV-PVT and NAV-TIMEUTC lay out their date and time alike
+void TinyGPS::ubx_datetime()
+{
+  unsigned long now = _sentence_time;
+  byte valid = _ubx_time >> 24;
+  if (valid & 0x01)
+  {
+    unsigned int year = _ubx_date & 0xFFFF;
+    byte month = _ubx_date >> 16, day = _ubx_date >> 24;
+    _new.date = day * 10000UL + month * 100U + year % 100;
+    _changed |= GPS_CHANGED_DATE;
+#ifndef _GPS_NO_ZDA
+    _new.year = year;
+    _new.month = month;
+    _new.day = day;
+    _new.date_fix = now;
+    _changed |= GPS_CHANGED_YMD | _GPS_CHANGED_MONTH | _GPS_CHANGED_YEAR;
+#endif
+#ifndef _GPS_NO_EPOCH
+    _new.utc.year = year;
+    _new.utc.month = month;
+    _new.utc.day = day;
 #endif
+  }
+  if (valid & 0x02)
+  {
+    byte hour = _ubx_time, minute = _ubx_time >> 8, second = _ubx_time >> 16;
+    // a negative nano means a moment before the second, well within its 100th
+    byte hundredths = _ubx_nano > 0 ? _ubx_nano / 10000000L : 0;
+    _new.time = hour * 1000000UL + minute * 10000UL + second * 100U + hundredths;
+    _new.time_fix = now;
+    _changed |= GPS_CHANGED_TIME;
+#ifndef _GPS_NO_EPOCH
+    _new.utc.hour = hour;
+    _new.utc.minute = minute;
+    _new.utc.second = second;
+    _new.utc.hundredths = hundredths;
+#endif
+  }
+}
+
+// A frame whose checksum passed. NAV-PVT commits like RMC, with or
+// without a fix, NAV-TIMEUTC like ZDA and NAV-SAT like a GSV sequence;
+// NAV-DOP's hDOP waits for the NAV-PVT of the same epoch, which follows it.
+bool TinyGPS::ubx_complete()
 {
-  _term[0] = '\0';
+  switch (_ubx_message)
+  {
+  case _GPS_UBX_NAV_PVT:
+    if (_ubx_length != 92)
+      break;
+    ubx_datetime();
+    _new.position_fix = _sentence_time;
+    _changed |= GPS_CHANGED_POSITION | _GPS_CHANGED_LONGITUDE | GPS_CHANGED_ALTITUDE |
+      GPS_CHANGED_SPEED | GPS_CHANGED_COURSE | GPS_CHANGED_SATELLITES;
+#ifndef _GPS_NO_KINEMATICS
+    _changed |= GPS_CHANGED_VERTICAL;
+#endif
+#ifdef _GPS_LAZY_DECODE
+    _new.text.altitude[0] = _new.text.course[0] = 0;
+#endif
+    if (_ubx_hdop != 0xFFFF)
+    {
+      _new.hdop = _ubx_hdop;
+      _changed |= GPS_CHANGED_HDOP;
+      _ubx_hdop = 0xFFFF;
+#ifdef _GPS_LAZY_DECODE
+      _new.text.hdop[0] = 0;
+#endif
+    }
+    return commit_sentence();
+  case _GPS_UBX_NAV_TIMEUTC:
+    if (_ubx_length != 20)
+      break;
+    ubx_datetime();
+    return commit_sentence();
+#ifndef _GPS_NO_GSV
+  case _GPS_UBX_NAV_SAT:
+    if (_ubx_length < 8)
+      break;
+    return commit_sentence();
+#endif
+  case _GPS_UBX_NAV_DOP:
+    if (_ubx_length == 18)
+      _ubx_hdop = _new.hdop;
+    break;
+  }
+  // other messages are only counted
+#ifndef _GPS_NO_STATS
+  ++_stats.passed_checksum;
+  ++_stats.accepted[_GPS_SENTENCE_UBX];
+#endif
+  return false;
 }
+#endif
 
 //
-// public methods
+// integer geodesy: angles in millionths of a degree, sin and atan from
+// linearly interpolated tables, no floating point
 //
 
-bool TinyGPS::encode(char c)
-{
-  bool valid_sentence = false;
+#define _GPS_MICRODEG_90  90000000L
+#define _GPS_MICRODEG_180 180000000L
+#define _GPS_MICRODEG_360 360000000L
+#define _GPS_FLAT_LIMIT 0x80000L // separations below about half a degree go flat
+// meters per millionth of a degree << 19, for the same 6372795 m sphere as distance_between()
+#define _GPS_METERS_PER_MICRODEG_Q19 58315U
+// millionths of a degree per radian, over 2^24 and << 14
+#define _GPS_MICRODEG_PER_RADIAN_Q14 55953U
+// half a millionth of a degree in radians << 42
+#define _GPS_HALF_RADIANS_PER_MICRODEG_Q42 38380U
+// a millionth of a degree in radians << 30, 18.74 rounded
+#define _GPS_RADIANS_PER_MICRODEG_Q30 19U
 
-#ifndef _GPS_NO_STATS
-  ++_encoded_characters;
-#endif
-  switch(c)
-  {
-  case ',': // term terminators
-    _parity ^= c;
-  case '\r':
-  case '\n':
-  case '*':
-    if (_term_offset < sizeof(_term))
-    {
-      _term[_term_offset] = 0;
-      valid_sentence = term_complete();
-    }
-    ++_term_number;
-    _term_offset = 0;
-    _is_checksum_term = c == '*';
-    return valid_sentence;
+// (2^20 millionths of a degree in radians)^2 / 2 << 26
+#define _GPS_SIN_CHORD_Q26 11239U
 
-  case '$': // sentence begin
-    _term_number = _term_offset = 0;
-    _parity = 0;
-    _sentence_type = _GPS_SENTENCE_OTHER;
-    _is_checksum_term = false;
-    _gps_data_good = false;
-    return valid_sentence;
-  }
+// sin(i * 2^20 millionths of a degree) << 30, i = 0..86
+static const uint32_t _gps_sin_table[] PROGMEM = {
+  0UL, 19649564UL, 39292546UL, 58922369UL, 78532457UL, 98116243UL,
+  117667168UL, 137178683UL, 156644255UL, 176057363UL, 195411506UL, 214700201UL,
+  233916989UL, 253055433UL, 272109124UL, 291071679UL, 309936748UL, 328698013UL,
+  347349191UL, 365884033UL, 384296333UL, 402579925UL, 420728684UL, 438736532UL,
+  456597438UL, 474305420UL, 491854546UL, 509238941UL, 526452781UL, 543490300UL,
+  560345793UL, 577013615UL, 593488183UL, 609763979UL, 625835552UL, 641697519UL,
+  657344569UL, 672771460UL, 687973026UL, 702944175UL, 717679894UL, 732175246UL,
+  746425377UL, 760425515UL, 774170970UL, 787657139UL, 800879505UL, 813833640UL,
+  826515205UL, 838919952UL, 851043728UL, 862882471UL, 874432216UL, 885689096UL,
+  896649340UL, 907309277UL, 917665337UL, 927714052UL, 937452055UL, 946876087UL,
+  955982989UL, 964769713UL, 973233315UL, 981370961UL, 989179925UL, 996657592UL,
+  1003801457UL, 1010609128UL, 1017078324UL, 1023206880UL, 1028992742UL, 1034433973UL,
+  1039528750UL, 1044275367UL, 1048672235UL, 1052717880UL, 1056410947UL, 1059750201UL,
+  1062734521UL, 1065362910UL, 1067634486UL, 1069548488UL, 1071104277UL, 1072301330UL,
+  1073139247UL, 1073617747UL, 1073736669UL
+};
 
-  // ordinary characters
-  if (_term_offset < sizeof(_term) - 1)
-    _term[_term_offset++] = c;
-  if (!_is_checksum_term)
-    _parity ^= c;
+// atan(i / 64) in millionths of a degree, i = 0..65
+static const uint32_t _gps_atan_table[] PROGMEM = {
+  0UL, 895174UL, 1789911UL, 2683775UL, 3576334UL, 4467159UL,
+  5355825UL, 6241914UL, 7125016UL, 8004729UL, 8880659UL, 9752425UL,
+  10619655UL, 11481991UL, 12339087UL, 13190611UL, 14036243UL, 14875682UL,
+  15708638UL, 16534838UL, 17354025UL, 18165957UL, 18970408UL, 19767169UL,
+  20556045UL, 21336859UL, 22109448UL, 22873665UL, 23629378UL, 24376469UL,
+  25114835UL, 25844388UL, 26565051UL, 27276763UL, 27979474UL, 28673146UL,
+  29357754UL, 30033280UL, 30699723UL, 31357085UL, 32005383UL, 32644640UL,
+  33274888UL, 33896167UL, 34508523UL, 35112011UL, 35706691UL, 36292630UL,
+  36869898UL, 37438572UL, 37998732UL, 38550465UL, 39093859UL, 39629005UL,
+  40156000UL, 40674940UL, 41185925UL, 41689058UL, 42184443UL, 42672185UL,
+  43152390UL, 43625165UL, 44090620UL, 44548861UL, 45000000UL, 45444144UL
+};
 
-  return valid_sentence;
+// floor(a * b / 2^16) without a 64-bit product
+static unsigned long _gps_mul16(unsigned long a, uint16_t b)
+{
+  return (a >> 16) * b + (((a & 0xFFFF) * b) >> 16);
 }
 
-#ifndef _GPS_NO_STATS
-void TinyGPS::stats(unsigned long *chars, unsigned short *sentences, unsigned short *failed_cs)
+// a * b / 2^30 for |a|, |b| <= 2^30
+static long _gps_mul30(long a, long b)
 {
-  if (chars) *chars = _encoded_characters;
-  if (sentences) *sentences = _good_sentences;
-  if (failed_cs) *failed_cs = _failed_checksum;
+  bool neg = (a < 0) != (b < 0);
+  unsigned long ua = a < 0 ? -(unsigned long)a : a;
+  unsigned long ub = b < 0 ? -(unsigned long)b : b;
+  unsigned long ah = ua >> 15, al = ua & 0x7FFF, bh = ub >> 15, bl = ub & 0x7FFF;
+  unsigned long r = ah * bh + ((ah * bl + al * bh + ((al * bl) >> 15)) >> 15);
+  return neg ? -(long)r : (long)r;
 }
-#endif
 
-//
-// internal utilities
-//
-int TinyGPS::from_hex(char a) 
+// sin(x) << 30
+static long _gps_sin(long x)
 {
-  if (a >= 'A' && a <= 'F')
-    return a - 'A' + 10;
-  else if (a >= 'a' && a <= 'f')
-    return a - 'a' + 10;
+  while (x < 0) x += _GPS_MICRODEG_360;
+  while (x >= _GPS_MICRODEG_360) x -= _GPS_MICRODEG_360;
+  bool neg = x >= _GPS_MICRODEG_180;
+  if (neg) x -= _GPS_MICRODEG_180;
+  if (x > _GPS_MICRODEG_90) x = _GPS_MICRODEG_180 - x;
+  unsigned long s0 = pgm_read_dword(&_gps_sin_table[x >> 20]);
+  unsigned long s1 = pgm_read_dword(&_gps_sin_table[(x >> 20) + 1]);
+  uint16_t f = (x & 0xFFFFF) >> 4;
+  // the four bits f drops span 16 millionths of a degree, up to 300 / 2^30
+  // of sine near 0
+  unsigned long s = s0 + _gps_mul16(s1 - s0, f) + (_gps_mul16(s1 - s0, (x & 15) << 12) >> 16);
+  // the chord lies below the curve by sin(x) * f * (1 - f) * step^2 / 2
+  s += _gps_mul16(_gps_mul16(s, _gps_mul16(f, 0x10000UL - f)), _GPS_SIN_CHORD_Q26) >> 10;
+  return neg ? -(long)s : (long)s;
+}
+
+static long _gps_cos(long x)
+{
+  return _gps_sin(x + _GPS_MICRODEG_90);
+}
+
+#ifndef _GPS_NO_KINEMATICS
+// Derives the velocity of a fix that carried speed or course, so that
+// speed_mms() and get_velocity() are plain loads
+void TinyGPS::settle_kinematics()
+{
+  if (!(_changed & (GPS_CHANGED_SPEED | GPS_CHANGED_COURSE)))
+    return;
+  Kinematics &v = _new.velocity;
+  if (_new.speed == GPS_INVALID_SPEED)
+  {
+    v.speed = GPS_INVALID_SPEED;
+    v.north = v.east = GPS_INVALID_SPEED;
+    return;
+  }
+  v.speed = (_new.speed * 463 + 45) / 90; // 100ths of a knot to mm/s
+  uint16_t course = _new.course;
+#ifdef _GPS_LAZY_DECODE
+  if (_new.text.course[0])
+    course = clamp16(parse_decimal(_new.text.course, _new.text.course + strlen(_new.text.course)));
+#endif
+  if (course == 0xFFFF)
+    v.north = v.east = GPS_INVALID_SPEED;
   else
-    return a - '0';
+  {
+    long angle = course * 10000L;
+    v.north = _gps_mul30(v.speed, _gps_cos(angle));
+    v.east = _gps_mul30(v.speed, _gps_sin(angle));
+  }
 }
+#endif
 
-unsigned long TinyGPS::parse_decimal()
+// lo / hi << 24 for lo <= hi, by restoring division a bit at a time
+static unsigned long _gps_ratio24(unsigned long lo, unsigned long hi)
 {
-  char *p = _term;
-  bool isneg = *p == '-';
-  if (isneg) ++p;
-  unsigned long ret = 100UL * gpsatol(p);
-  while (gpsisdigit(*p)) ++p;
-  if (*p == '.')
+  if (hi & 0x80000000UL)
+  {
+    hi >>= 1;
+    lo >>= 1;
+  }
+  unsigned long r = 0;
+  if (lo >= hi)
+  {
+    lo -= hi;
+    r = 1;
+  }
+  for (byte i = 0; i < 24; ++i)
   {
-    if (gpsisdigit(p[1]))
+    lo <<= 1;
+    r <<= 1;
+    if (lo >= hi)
     {
-      ret += 10 * (p[1] - '0');
-      if (gpsisdigit(p[2]))
-        ret += p[2] - '0';
+      lo -= hi;
+      r |= 1;
     }
   }
-  return isneg ? -ret : ret;
+  return r;
+}
+
+// atan2(y, x) in millionths of a degree, (-180, 180] degrees
+static long _gps_atan2(long y, long x)
+{
+  unsigned long ay = y < 0 ? -(unsigned long)y : y;
+  unsigned long ax = x < 0 ? -(unsigned long)x : x;
+  bool steep = ay > ax;
+  unsigned long lo = steep ? ax : ay, hi = steep ? ay : ax;
+  if (!hi)
+    return 0;
+  unsigned long r = _gps_ratio24(lo, hi); // tangent within the octant
+  byte i = r >> 18;
+  long a = pgm_read_dword(&_gps_atan_table[i]);
+  if (i == 0)
+  {
+    // below 1/64 the series is closer than any chord: atan(r) = r - r^3 / 3
+    a = _gps_mul16(r << 2, _GPS_MICRODEG_PER_RADIAN_Q14);
+    uint16_t u = r >> 8;
+    a -= _gps_mul16(_gps_mul16(a, u), u) / 3;
+  }
+  else if (i < 64)
+  {
+    // interpolate, bending the chord by the second differences either side
+    long t0 = pgm_read_dword(&_gps_atan_table[i - 1]);
+    long t2 = pgm_read_dword(&_gps_atan_table[i + 1]);
+    long t3 = pgm_read_dword(&_gps_atan_table[i + 2]);
+    uint16_t f = (r >> 2) & 0xFFFF;
+    long bend = t0 - a - t2 + t3;
+    a += _gps_mul16(t2 - a, f) - bend * (long)_gps_mul16(f, 0x10000UL - f) / 0x40000L;
+  }
+  if (steep) a = _GPS_MICRODEG_90 - a;
+  if (x < 0) a = _GPS_MICRODEG_180 - a;
+  return y < 0 ? -a : a;
 }
 
-// Parse a string in the form ddmm.mmmmmmm...
-unsigned long TinyGPS::parse_degrees()
+static unsigned long _gps_isqrt(unsigned long v)
 {
-  char *p;
-  unsigned long left_of_decimal = gpsatol(_term);
-  unsigned long hundred1000ths_of_minute = (left_of_decimal % 100UL) * 100000UL;
-  for (p=_term; gpsisdigit(*p); ++p);
-  if (*p == '.')
+  unsigned long r = 0, bit = 1UL << 30;
+  while (bit > v)
+    bit >>= 2;
+  while (bit)
   {
-    unsigned long mult = 10000;
-    while (gpsisdigit(*++p))
+    if (v >= r + bit)
     {
-      hundred1000ths_of_minute += mult * (*p - '0');
-      mult /= 10;
+      v -= r + bit;
+      r = (r >> 1) + bit;
     }
+    else
+      r >>= 1;
+    bit >>= 2;
   }
-  return (left_of_decimal / 100) * 1000000 + (hundred1000ths_of_minute + 3) / 6;
+  return r;
 }
 
-#define COMBINE(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | term_number)
-#define UBX_MESSAGE(message_type) (((unsigned)(_GPS_SENTENCE_PUBX) << 5) | message_type)
+static long _gps_wrap180(long d)
+{
+  if (d > _GPS_MICRODEG_180) d -= _GPS_MICRODEG_360;
+  else if (d <= -_GPS_MICRODEG_180) d += _GPS_MICRODEG_360;
+  return d;
+}
 
-// Processes a just-completed term
-// Returns true if new sentence has just passed checksum test and is validated
-bool TinyGPS::term_complete()
+static bool _gps_is_flat(long dlat, long dlon)
 {
-  if (_is_checksum_term)
-  {
-    byte checksum = 16 * from_hex(_term[0]) + from_hex(_term[1]);
-    if (checksum == _parity)
-    {
-      /*
-// DEBUG TEMP ADDITION
-      Serial.printf("TinyGPS: sentence: ");
-      switch(_sentence_type) 
-      {
-        case _GPS_SENTENCE_GPGGA:   Serial.printf("*%s ", _GPGGA_TERM);    break;
-        case _GPS_SENTENCE_GPRMC:   Serial.printf("*%s ", _GPRMC_TERM);    break;
-        case _GPS_SENTENCE_GNGNS:   Serial.printf("%s ", _GNGNS_TERM);    break;
-        case _GPS_SENTENCE_GNGSA:   Serial.printf("%s ", _GNGSA_TERM);    break;
-        case _GPS_SENTENCE_GPGSV:   Serial.printf("%s ", _GPGSV_TERM);    break;
-        case _GPS_SENTENCE_GLGSV:   Serial.printf("%s ", _GLGSV_TERM);    break;
-        case _GPS_SENTENCE_PUBX:    Serial.printf("%s%02d ", _PUBX_TERM, _UBX_message_type);    break;
-        case _GPS_SENTENCE_OTHER:   Serial.printf("OTHER ");    break;
-      }
-      Serial.printf(" %s", _gps_data_good ? "Fix" : "No Fix - ");
-// END DEBUG TEMP ADDITION
-*/
-     //set the time and date even if not tracking 
-     if(_sentence_type == _GPS_SENTENCE_GPRMC || 
-        ((_sentence_type == _GPS_SENTENCE_PUBX) && (_UBX_message_type == 4)))   // UBX,04 Time of Day and Clock Information
-      {  
-          _time      = _new_time;
-          _date      = _new_date;
-          _last_time_fix = _new_time_fix;
-// temp debug
-//Serial.printf(" setting time (%ld)/date (%ld)", _new_time, _new_date);
-      }
-// Temp Debug
-//Serial.println();
+  return dlat < _GPS_FLAT_LIMIT && dlat > -_GPS_FLAT_LIMIT &&
+    dlon < _GPS_FLAT_LIMIT && dlon > -_GPS_FLAT_LIMIT;
+}
 
-      if (_sentence_type == _GPS_SENTENCE_GPZDA) // Date and Time information with full year info
-      {
-        _time = _new_time;
-        _last_time_fix = _new_time_fix;
-        _day = _new_day;
-        _month = _new_month;
-        _year = _new_year;
-        _last_date_fix = _new_date_fix;
-      }
+// east-west component of a flat separation, cos_lat << 30 at the mean latitude
+static long _gps_flat_east(long dlon, long cos_lat)
+{
+  return _gps_mul30(dlon, cos_lat);
+}
 
-      if (_gps_data_good)
-      {
-#ifndef _GPS_NO_STATS
-        ++_good_sentences;
-#endif
-        _last_time_fix = _new_time_fix;
-        _last_position_fix = _new_position_fix;
-
-        switch(_sentence_type)
-        {
-        case _GPS_SENTENCE_GPRMC:
-          _time      = _new_time;
-          _date      = _new_date;
-          _latitude  = _new_latitude;
-          _longitude = _new_longitude;
-          _speed     = _new_speed;
-          _course    = _new_course;
-          break;
-        case _GPS_SENTENCE_GPGGA:
-          _altitude  = _new_altitude;
-          _time      = _new_time;
-          _latitude  = _new_latitude;
-          _longitude = _new_longitude;
-          _numsats   = _new_numsats;
-          _hdop      = _new_hdop;
-          break;
-        case _GPS_SENTENCE_PUBX:
-          switch (_UBX_message_type) {
-          case 0:                         // UBX,00 Lat/Long Position Data
-            _time      = _new_time;
-            _latitude  = _new_latitude;
-            _longitude = _new_longitude;
-            _speed     = _new_speed;
-            _course    = _new_course;
-	          _altitude  = _new_altitude;
-	          _numsats   = _new_numsats;
-            _hdop      = _new_hdop;
-            break;
-          }
-          break;
-        }
-
-        return true;
-      }
-    }
+static unsigned long _gps_meters(unsigned long microdegrees)
+{
+  return (_gps_mul16(microdegrees, _GPS_METERS_PER_MICRODEG_Q19) + 4) >> 3;
+}
 
-#ifndef _GPS_NO_STATS
-    else
-      ++_failed_checksum;
-#endif
-    return false;
+// sqrt(a^2 + b^2): a root of the squares scaled to fit in 32 bits, refined
+// by one step of hypot = a + b^2 / (a + hypot)
+static unsigned long _gps_hypot(unsigned long a, unsigned long b)
+{
+  if (a < b)
+  {
+    unsigned long t = a;
+    a = b;
+    b = t;
   }
-
-  // the first term determines the sentence type
-  if (_term_number == 0)
+  if (!b)
+    return a;
+  unsigned long sa = a, sb = b;
+  byte k = 0;
+  for (; sa >= 0x8000; ++k)
   {
-    if (!gpsstrcmp(_term, _GPRMC_TERM) || !gpsstrcmp(_term, _GNRMC_TERM))
-      _sentence_type = _GPS_SENTENCE_GPRMC;
-    else if (!gpsstrcmp(_term, _GPGGA_TERM))
-      _sentence_type = _GPS_SENTENCE_GPGGA;
-    else if (!gpsstrcmp(_term, _GNGNS_TERM))
-      _sentence_type = _GPS_SENTENCE_GNGNS;
-    else if (!gpsstrcmp(_term, _GNGSA_TERM) || !gpsstrcmp(_term, _GPGSA_TERM))
-      _sentence_type = _GPS_SENTENCE_GNGSA;
-    else if (!gpsstrcmp(_term, _GPGSV_TERM))
-      _sentence_type = _GPS_SENTENCE_GPGSV;
-    else if (!gpsstrcmp(_term, _GLGSV_TERM))
-      _sentence_type = _GPS_SENTENCE_GLGSV;
-    else if (!gpsstrcmp(_term, _GPZDA_TERM))
-      _sentence_type = _GPS_SENTENCE_GPZDA;
-    else if (!gpsstrcmp(_term, _PUBX_TERM))
-      _sentence_type = _GPS_SENTENCE_PUBX;
-    else
-      _sentence_type = _GPS_SENTENCE_OTHER;
-    return false;
+    sa >>= 1;
+    sb >>= 1;
   }
+  unsigned long h = _gps_isqrt(sa * sa + sb * sb) << k;
+  return a + _gps_mul16(b, _gps_ratio24(b, a + h) >> 8);
+}
+
+static unsigned long _gps_abs(long v)
+{
+  return v < 0 ? -(unsigned long)v : v;
+}
+
+// Short separations use the equirectangular projection, within a meter or
+// 0.05% of the great circle below half a degree and free of any trig but
+// one cosine
+static unsigned long _gps_flat_distance(long dlat, long dlon, long cos_lat)
+{
+  return _gps_meters(_gps_hypot(_gps_abs(dlat), _gps_abs(_gps_flat_east(dlon, cos_lat))));
+}
+
+// Central angle c from sin^2(c/2) = (sin(dlat/2) cos(dlon/2))^2 + (cos(lat) sin(dlon/2))^2
+// and cos^2(c/2) = (cos(dlat/2) cos(dlon/2))^2 + (sin(lat) sin(dlon/2))^2, lat
+// being the mean latitude. Both are sums of squares, so neither loses
+// precision for short separations or near the antipode.
+static unsigned long _gps_central_meters(long sdlat, long cdlat, long sdlon, long cdlon, long slat, long clat)
+{
+  unsigned long s = _gps_hypot(_gps_abs(_gps_mul30(sdlat, cdlon)), _gps_abs(_gps_mul30(clat, sdlon)));
+  unsigned long c = _gps_hypot(_gps_abs(_gps_mul30(cdlat, cdlon)), _gps_abs(_gps_mul30(slat, sdlon)));
+  return _gps_meters(2 * _gps_atan2(s, c));
+}
 
-  // PUBX messages, use 1st term to determine the message content 
-  // save the message number
-  if (_sentence_type == _GPS_SENTENCE_PUBX && _term_number == 1)
+static unsigned long _gps_great_circle(long dlat, long dlon, long mean_lat)
+{
+  return _gps_central_meters(_gps_sin(dlat / 2), _gps_cos(dlat / 2), _gps_sin(dlon / 2), _gps_cos(dlon / 2),
+    _gps_sin(mean_lat), _gps_cos(mean_lat));
+}
+
+/* static */
+unsigned long TinyGPS::int_distance_between(long lat1, long long1, long lat2, long long2)
+{
+  long dlat = lat2 - lat1;
+  long dlon = _gps_wrap180(long2 - long1);
+  if (_gps_is_flat(dlat, dlon))
+    return _gps_flat_distance(dlat, dlon, _gps_cos(lat1 + dlat / 2));
+  return _gps_great_circle(dlat, dlon, lat1 + dlat / 2);
+}
+
+/* static */
+unsigned int TinyGPS::int_course_to(long lat1, long long1, long lat2, long long2)
+{
+  long dlat = lat2 - lat1;
+  long dlon = _gps_wrap180(long2 - long1);
+  long course;
+  if (_gps_is_flat(dlat, dlon))
   {
-    _UBX_message_type = gpsatol(_term);
-#ifdef DEBUG    
-    Serial.print("_GPS_SENTENCE_PUBX "); Serial.println(_UBX_message_type);
-#endif
-    return false;
+    // the flat bearing is the one at the midpoint, meridians converge by
+    // dlon * sin(lat) between the ends
+    long mean = lat1 + dlat / 2;
+    course = _gps_atan2(_gps_flat_east(dlon, _gps_cos(mean)), dlat) -
+      _gps_mul30(dlon, _gps_sin(mean)) / 2;
   }
+  else
+  {
+    long cos_lat2 = _gps_cos(lat2);
+    long y = _gps_mul30(_gps_sin(dlon), cos_lat2);
+    long x = _gps_mul30(_gps_cos(lat1), _gps_sin(lat2)) -
+      _gps_mul30(_gps_mul30(_gps_sin(lat1), cos_lat2), _gps_cos(dlon));
+    course = _gps_atan2(y, x);
+  }
+  if (course < 0)
+    course += _GPS_MICRODEG_360;
+  return ((course + 5000) / 10000) % 36000;
+}
 
-  // Dan - Added encoding of the sub message in the PUBX type
-  if (_sentence_type != _GPS_SENTENCE_OTHER && _term[0])
+// The origin's sine and cosine are computed once. For nearby points the
+// cosine at the mean latitude is cos(lat) - sin(lat) * dlat / 2, dlat in
+// radians, which is within 0.001% below half a degree, so those points need
+// no trig at all; distant ones cost the same as int_distance_between().
+/* static */
+void TinyGPS::distances_to(long lat, long lon, const Point *pts, size_t n, unsigned long *out)
+{
+  long cos_lat = _gps_cos(lat), sin_lat = _gps_sin(lat);
+  for (size_t i = 0; i < n; ++i)
   {
-    unsigned int sentence_type = _sentence_type;
-    if (_sentence_type == _GPS_SENTENCE_PUBX) {
-      sentence_type = UBX_MESSAGE(_UBX_message_type);
-    }
-    switch(COMBINE(sentence_type, _term_number))
+    long dlat = pts[i].latitude - lat;
+    long dlon = _gps_wrap180(pts[i].longitude - lon);
+    if (_gps_is_flat(dlat, dlon))
     {
-    case COMBINE(_GPS_SENTENCE_GPRMC, 1): // Time in these sentences
-    case COMBINE(_GPS_SENTENCE_GPGGA, 1):
-    case COMBINE(_GPS_SENTENCE_GNGNS, 1):
-    case COMBINE(_GPS_SENTENCE_GPZDA, 1):
-    case COMBINE(UBX_MESSAGE(0), 2):      // UBX,00 Lat/Long Position Data
-    case COMBINE(UBX_MESSAGE(4), 2):      // UBX,04 Time of Day and Clock Information
-//Serial.printf("GPS: capturing time from sentence (%d) term (%d)\n", sentence_type, _term_number);
-      _new_time = parse_decimal();
-      _new_time_fix = millis();
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 2): // GPRMC validity
-      _gps_data_good = _term[0] == 'A';
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 3): // Latitude
-    case COMBINE(_GPS_SENTENCE_GPGGA, 2):
-    case COMBINE(_GPS_SENTENCE_GNGNS, 2):
-    case COMBINE(UBX_MESSAGE(0), 3):      // UBX,00 Lat/Long Position Data
-      _new_latitude = parse_degrees();
-      _new_position_fix = millis();
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 4): // N/S
-    case COMBINE(_GPS_SENTENCE_GPGGA, 3):
-    case COMBINE(_GPS_SENTENCE_GNGNS, 3):
-    case COMBINE(UBX_MESSAGE(0), 4):      // UBX,00 Lat/Long Position Data
-      if (_term[0] == 'S')
-        _new_latitude = -_new_latitude;
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 5): // Longitude
-    case COMBINE(_GPS_SENTENCE_GPGGA, 4):
-    case COMBINE(_GPS_SENTENCE_GNGNS, 4):
-    case COMBINE(UBX_MESSAGE(0), 5):      // UBX,00 Lat/Long Position Data
-      _new_longitude = parse_degrees();
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 6): // E/W
-    case COMBINE(_GPS_SENTENCE_GPGGA, 5):
-    case COMBINE(_GPS_SENTENCE_GNGNS, 5):
-     case COMBINE(UBX_MESSAGE(0), 6):      // UBX,00 Lat/Long Position Data
-      if (_term[0] == 'W')
-        _new_longitude = -_new_longitude;
-      break;
-    case COMBINE(_GPS_SENTENCE_GNGNS, 6):
-      strncpy(_constellations, _term, 5);
-      _constellations[5] = 0;
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 7): // Speed (GPRMC)
-    case COMBINE(UBX_MESSAGE(0), 11):     // UBX,00 Lat/Long Position Data
-      _new_speed = parse_decimal();
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 8): // Course (GPRMC)
-    case COMBINE(UBX_MESSAGE(0), 12):     // UBX,00 Lat/Long Position Data
-      _new_course = parse_decimal();
-      break;
-    case COMBINE(_GPS_SENTENCE_GPRMC, 9): // Date (GPRMC)
-    case COMBINE(UBX_MESSAGE(4), 3):     // UBX,04 Time of Day and Clock Information
-//Serial.printf("GPS: capturing date from sentence (%d) term (%d)\n", sentence_type, _term_number);
-       _new_date = gpsatol(_term);
-      break;
-    case COMBINE(_GPS_SENTENCE_GPZDA, 2): // Day
-      _new_day = gpsatol(_term);
-      _new_date_fix = millis();
-      break; 
-    case COMBINE(_GPS_SENTENCE_GPZDA, 3): // Month
-      _new_month = gpsatol(_term);
-      _new_date_fix = millis();
-      break; 
-    case COMBINE(_GPS_SENTENCE_GPZDA, 4): // year
-      _new_year = gpsatol(_term);
-      _new_date_fix = millis();
-      break; 
-    case COMBINE(_GPS_SENTENCE_GPGGA, 6): // Fix data (GPGGA)
-      _gps_data_good = _term[0] > '0';
-      break;
-    case COMBINE(_GPS_SENTENCE_GPGGA, 7): // Satellites used (GPGGA): GPS only
-    case COMBINE(_GPS_SENTENCE_GNGNS, 7): // GNGNS counts-in all constellations
-    case COMBINE(UBX_MESSAGE(0), 18):     // UBX,00 Lat/Long Position Data
-      _new_numsats = (unsigned char)atoi(_term);
-      break;
-    case COMBINE(_GPS_SENTENCE_GPGGA, 8): // HDOP
-    case COMBINE(UBX_MESSAGE(0), 15):     // UBX,00 Lat/Long Position Data
-      _new_hdop = parse_decimal();
-      break;
-    case COMBINE(_GPS_SENTENCE_GPGGA, 9): // Altitude (GPGGA)
-    case COMBINE(UBX_MESSAGE(0), 7):      // UBX,00 Lat/Long Position Data
-      _new_altitude = parse_decimal();
-      break;
-    case COMBINE(UBX_MESSAGE(0), 8):      // UBX,00 Lat/Long Position Data
-      // Checking Navigation Status - ok if G2, G3, D2, D3 not ok on NF, DR, RK, or TT
-#ifdef DEBUG
-      Serial.print("NavStat: "); Serial.print(_term[0]); Serial.println(_term[1]);
-#endif
-      _gps_data_good = (_term[0] == 'G' || (_term[0] == 'D' && _term[1] != 'R'));
-      break;
-    case COMBINE(_GPS_SENTENCE_GNGSA, 3): //satellites used in solution: 3 to 15
-      //_sats_used[
-      break;
-    case COMBINE(_GPS_SENTENCE_GPGSV, 2):   //beginning of sequence
-    case COMBINE(_GPS_SENTENCE_GLGSV, 2):   //beginning of sequence
-    {
-      uint8_t msgId = atoi(_term)-1;  //start from 0
-      if(msgId == 0) {
-        //http://geostar-navigation.com/file/geos3/geos_nmea_protocol_v3_0_eng.pdf
-        if(_sentence_type == _GPS_SENTENCE_GPGSV) {
-          //reset GPS & WAAS trackedSatellites
-          for(uint8_t x=0;x<12;x++)
-          {
-            tracked_sat_rec[x] = 0;
-          }
-        } else {
-          //reset GLONASS trackedSatellites: range starts with 23
-          for(uint8_t x=12;x<24;x++)
-          {
-            tracked_sat_rec[x] = 0;
-          }
-        }
-      }
-      _sat_index = msgId*4;   //4 sattelites/line
-      if(_sentence_type == _GPS_SENTENCE_GLGSV)
-      {
-        _sat_index = msgId*4 + 12;   //Glonass offset by 12
-      }
-      break;
+      long half = _gps_mul16((unsigned long)(dlat < 0 ? -dlat : dlat) << 4, _GPS_HALF_RADIANS_PER_MICRODEG_Q42);
+      long cos_mean = cos_lat - _gps_mul30(sin_lat, dlat < 0 ? -half : half);
+      out[i] = _gps_flat_distance(dlat, dlon, cos_mean);
     }
-    case COMBINE(_GPS_SENTENCE_GPGSV, 4):   //satellite #
-    case COMBINE(_GPS_SENTENCE_GPGSV, 8):
-    case COMBINE(_GPS_SENTENCE_GPGSV, 12):
-    case COMBINE(_GPS_SENTENCE_GPGSV, 16):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 4):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 8):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 12):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 16):
-      _tracked_satellites_index = atoi(_term);
-      break;
-    case COMBINE(_GPS_SENTENCE_GPGSV, 7):   //strength
-    case COMBINE(_GPS_SENTENCE_GPGSV, 11):
-    case COMBINE(_GPS_SENTENCE_GPGSV, 15):
-    case COMBINE(_GPS_SENTENCE_GPGSV, 19):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 7):   //strength
-    case COMBINE(_GPS_SENTENCE_GLGSV, 11):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 15):
-    case COMBINE(_GPS_SENTENCE_GLGSV, 19):
-      uint8_t stren = (uint8_t)atoi(_term);
-      if(stren == 0)  //remove the record, 0dB strength
-      {
-        tracked_sat_rec[_sat_index + (_term_number-7)/4] = 0;
-      }
-      else
-      {
-        tracked_sat_rec[_sat_index + (_term_number-7)/4] = _tracked_satellites_index<<8 | stren<<1;
-      }
-      break;
-    } 
+    else
+      out[i] = _gps_great_circle(dlat, dlon, lat + dlat / 2);
   }
- 
-  return false;
 }
 
-long TinyGPS::gpsatol(const char *str)
+// The trig of the mean latitude and of the half separations that the
+// distance needs gives the bearing's too: the ends' latitudes are the mean
+// -/+ half of dlat, and sin(dlon) follows from the sine and cosine of its
+// half.
+/* static */
+unsigned int TinyGPS::bearing_and_distance(long lat1, long long1, long lat2, long long2, unsigned long *distance)
 {
-  long ret = 0;
-  while (gpsisdigit(*str))
-    ret = 10 * ret + *str++ - '0';
-  return ret;
+  long dlat = lat2 - lat1;
+  long dlon = _gps_wrap180(long2 - long1);
+  long mean = lat1 + dlat / 2;
+  long slat = _gps_sin(mean), clat = _gps_cos(mean);
+  long course;
+  if (_gps_is_flat(dlat, dlon))
+  {
+    long east = _gps_flat_east(dlon, clat);
+    *distance = _gps_meters(_gps_hypot(_gps_abs(dlat), _gps_abs(east)));
+    course = _gps_atan2(east, dlat) - _gps_mul30(dlon, slat) / 2;
+  }
+  else
+  {
+    long sh = _gps_sin(dlat / 2), ch = _gps_cos(dlat / 2);
+    long sdlon = _gps_sin(dlon / 2), cdlon = _gps_cos(dlon / 2);
+    *distance = _gps_central_meters(sh, ch, sdlon, cdlon, slat, clat);
+    // x = cos(lat1) sin(lat2) - sin(lat1) cos(lat2) cos(dlon) as
+    // sin(dlat) + 2 sin(lat1) cos(lat2) sin^2(dlon / 2), which does not
+    // cancel near the poles
+    long sin_lat1 = _gps_mul30(slat, ch) - _gps_mul30(clat, sh);
+    long cos_lat2 = _gps_mul30(clat, ch) - _gps_mul30(slat, sh);
+    long y = _gps_mul30(2 * _gps_mul30(sdlon, cdlon), cos_lat2);
+    long x = 2 * (_gps_mul30(sh, ch) + _gps_mul30(_gps_mul30(sin_lat1, cos_lat2), _gps_mul30(sdlon, sdlon)));
+    // 2 sin(h) cos(h) is sin(dlat) short of the odd millionth that halving
+    // dropped, which matters when x itself is small
+    x += (dlat - dlat / 2 * 2) * (long)_GPS_RADIANS_PER_MICRODEG_Q30;
+    course = _gps_atan2(y, x);
+  }
+  if (course < 0)
+    course += _GPS_MICRODEG_360;
+  return ((course + 5000) / 10000) % 36000;
 }
 
-int TinyGPS::gpsstrcmp(const char *str1, const char *str2)
+// the 32 points of the compass, every other one being the 16 of cardinal()
+static const char _gps_points[32][5] = {
+  "N", "NbE", "NNE", "NEbN", "NE", "NEbE", "ENE", "EbN",
+  "E", "EbS", "ESE", "SEbE", "SE", "SEbS", "SSE", "SbE",
+  "S", "SbW", "SSW", "SWbS", "SW", "SWbW", "WSW", "WbS",
+  "W", "WbN", "WNW", "NWbW", "NW", "NWbN", "NNW", "NbW"
+};
+
+// The course becomes a 16-bit binary angle, 65536 to the turn, by one
+// multiply; rounding to the nearest of 2^k points is then a shift.
+/* static */
+const char *TinyGPS::int_cardinal(unsigned long course, byte points)
 {
-  while (*str1 && *str1 == *str2)
-    ++str1, ++str2;
-  return *str1;
+  if (course >= 36000)
+    return "";
+  uint16_t angle = (course * 59653UL) >> 15; // 65536 / 36000 << 15, rounded up
+  if (points == 32)
+    return _gps_points[((angle >> 10) + 1) >> 1 & 31];
+  return _gps_points[(((angle >> 11) + 1) >> 1 & 15) << 1];
 }
 
+#ifndef _GPS_NO_FLOAT
 /* static */
 float TinyGPS::distance_between (float lat1, float long1, float lat2, float long2) 
 {
@@ -559,63 +2298,252 @@ float TinyGPS::course_to (float lat1, float long1, float lat2, float long2)
 
 const char *TinyGPS::cardinal (float course)
 {
-  static const char* directions[] = {"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE", "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"};
+  long c = (long)(course * 100) % 36000;
+  return int_cardinal(c < 0 ? c + 36000 : c);
+}
+
+#endif
+
+// Copies the committed fix. encode() may run in an interrupt handler: if it
+// commits while the copy is in progress the copy is simply retried.
+void TinyGPS::get_fix(Fix &fix)
+{
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    fix = _fix;
+  } while (read_retry(seq));
+#ifdef _GPS_LAZY_DECODE
+  parse_deferred(fix.text, fix.altitude, fix.course, fix.hdop);
+  fix.text.altitude[0] = fix.text.course[0] = fix.text.hdop[0] = 0;
+#endif
+}
 
-  int direction = (int)((course + 11.25f) / 22.5f);
-  return directions[direction % 16];
+/* static */
+void TinyGPS::copy_fields(uint16_t changed, const Fix &from, Fix &to)
+{
+  if (changed & GPS_CHANGED_TIME)
+  {
+    to.time = from.time;
+    to.time_fix = from.time_fix;
+  }
+  if (changed & GPS_CHANGED_DATE)
+    to.date = from.date;
+  if (changed & GPS_CHANGED_POSITION)
+  {
+    to.latitude = from.latitude;
+    to.longitude = from.longitude;
+#ifdef _GPS_HIGH_PRECISION
+    to.latitude_nano = from.latitude_nano;
+    to.longitude_nano = from.longitude_nano;
+#endif
+    to.position_fix = from.position_fix;
+  }
+  if (changed & GPS_CHANGED_ALTITUDE)
+  {
+    to.altitude = from.altitude;
+#ifdef _GPS_LAZY_DECODE
+    memcpy(to.text.altitude, from.text.altitude, sizeof(to.text.altitude));
+#endif
+#ifdef _GPS_HIGH_PRECISION
+    to.altitude_mm = from.altitude_mm;
+#endif
+  }
+  if (changed & GPS_CHANGED_SPEED)
+    to.speed = from.speed;
+#ifndef _GPS_NO_KINEMATICS
+  if (changed & (GPS_CHANGED_SPEED | GPS_CHANGED_COURSE))
+  {
+    to.velocity.speed = from.velocity.speed;
+    to.velocity.north = from.velocity.north;
+    to.velocity.east = from.velocity.east;
+  }
+  if (changed & GPS_CHANGED_VERTICAL)
+    to.velocity.down = from.velocity.down;
+#endif
+  if (changed & GPS_CHANGED_COURSE)
+  {
+    to.course = from.course;
+#ifdef _GPS_LAZY_DECODE
+    memcpy(to.text.course, from.text.course, sizeof(to.text.course));
+#endif
+  }
+  if (changed & GPS_CHANGED_HDOP)
+  {
+    to.hdop = from.hdop;
+#ifdef _GPS_LAZY_DECODE
+    memcpy(to.text.hdop, from.text.hdop, sizeof(to.text.hdop));
+#endif
+  }
+  if (changed & GPS_CHANGED_SATELLITES)
+    to.numsats = from.numsats;
+#ifndef _GPS_NO_ZDA
+  if (changed & GPS_CHANGED_YMD)
+  {
+    to.year = from.year;
+    to.month = from.month;
+    to.day = from.day;
+    to.date_fix = from.date_fix;
+  }
+#endif
+#ifndef _GPS_NO_EPOCH
+  // the time and the date may come from different sentences, so the
+  // epoch is recomputed from the copied fields
+  if (changed & GPS_CHANGED_TIME)
+  {
+    to.utc.hour = from.utc.hour;
+    to.utc.minute = from.utc.minute;
+    to.utc.second = from.utc.second;
+    to.utc.hundredths = from.utc.hundredths;
+  }
+  if (changed & (GPS_CHANGED_DATE | GPS_CHANGED_YMD))
+  {
+    to.utc.year = from.utc.year;
+    to.utc.month = from.utc.month;
+    to.utc.day = from.utc.day;
+  }
+  if (changed & (GPS_CHANGED_TIME | GPS_CHANGED_DATE | GPS_CHANGED_YMD))
+    to.utc.epoch = to.time == GPS_INVALID_TIME ? 0 : epoch_seconds(to.utc.year,
+      to.utc.month, to.utc.day, to.utc.hour, to.utc.minute, to.utc.second);
+#endif
 }
 
 // lat/long in MILLIONTHs of a degree and age of fix in milliseconds
 // (note: versions 12 and earlier gave this value in 100,000ths of a degree.
 void TinyGPS::get_position(long *latitude, long *longitude, unsigned long *fix_age)
 {
-  if (latitude) *latitude = _latitude;
-  if (longitude) *longitude = _longitude;
-  if (fix_age) *fix_age = _last_position_fix == GPS_INVALID_FIX_TIME ? 
-   GPS_INVALID_AGE : millis() - _last_position_fix;
+  long lat, lon;
+  unsigned long position_fix;
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    lat = _fix.latitude;
+    lon = _fix.longitude;
+    position_fix = _fix.position_fix;
+  } while (read_retry(seq));
+
+  if (latitude) *latitude = lat;
+  if (longitude) *longitude = lon;
+  if (fix_age) *fix_age = position_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : now() - position_fix;
 }
 
-// date as ddmmyy, time as hhmmsscc, and age in milliseconds
-void TinyGPS::get_datetime(unsigned long *date, unsigned long *time, unsigned long *age)
+#ifndef _GPS_NO_KINEMATICS
+void TinyGPS::get_velocity(long *north, long *east, long *down)
 {
-  if (date) *date = _date;
-  if (time) *time = _time;
-  if (age) *age = _last_time_fix == GPS_INVALID_FIX_TIME ? 
-   GPS_INVALID_AGE : millis() - _last_time_fix;
+  Kinematics v;
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    v = _fix.velocity;
+  } while (read_retry(seq));
+
+  if (north) *north = v.north;
+  if (east) *east = v.east;
+  if (down) *down = v.down;
 }
+#endif
 
-void TinyGPS::get_datetime(int *year, byte *month, byte *day, 
-    byte *hour, byte *minute, byte *second, byte *hundredths = 0, unsigned long *age)
+#ifdef _GPS_HIGH_PRECISION
+// lat/long in BILLIONTHs of a degree and age of fix in milliseconds
+void TinyGPS::get_position_nano(int64_t *latitude, int64_t *longitude, unsigned long *fix_age)
 {
-  if (year) *year = _year;
-  if (month) *month = _month;
-  if (day) *day = _day;
+  int64_t lat, lon;
+  unsigned long position_fix;
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    lat = _fix.latitude_nano;
+    lon = _fix.longitude_nano;
+    position_fix = _fix.position_fix;
+  } while (read_retry(seq));
+
+  if (latitude) *latitude = lat;
+  if (longitude) *longitude = lon;
+  if (fix_age) *fix_age = position_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : now() - position_fix;
+}
+#endif
 
-  if (hour) *hour = _time / 1000000;
-  if (minute) *minute = (_time / 10000) % 100;
-  if (second) *second = (_time / 100) % 100;
-  if (hundredths) *hundredths = _time % 100;
-  if (age) *age = _last_date_fix == GPS_INVALID_FIX_TIME ? 
-   GPS_INVALID_AGE : millis() - _last_date_fix;
+// date as ddmmyy, time as hhmmsscc, and age in milliseconds
+void TinyGPS::get_datetime(unsigned long *date, unsigned long *time, unsigned long *age)
+{
+  unsigned long d, t, time_fix;
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    d = _fix.date;
+    t = _fix.time;
+    time_fix = _fix.time_fix;
+  } while (read_retry(seq));
 
+  if (date) *date = d;
+  if (time) *time = t;
+  if (age) *age = time_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : now() - time_fix;
 }
-void TinyGPS::f_get_position(float *latitude, float *longitude, unsigned long *fix_age)
+
+#ifndef _GPS_NO_ZDA
+void TinyGPS::get_datetime(int *year, byte *month, byte *day, 
+    byte *hour, byte *minute, byte *second, byte *hundredths, unsigned long *age)
 {
-  long lat, lon;
-  get_position(&lat, &lon, fix_age);
-  *latitude = lat == GPS_INVALID_ANGLE ? GPS_INVALID_F_ANGLE : (lat / 1000000.0);
-  *longitude = lat == GPS_INVALID_ANGLE ? GPS_INVALID_F_ANGLE : (lon / 1000000.0);
+  Fix fix;
+  get_fix(fix);
+  if (year) *year = fix.year;
+  if (month) *month = fix.month;
+  if (day) *day = fix.day;
+
+#ifndef _GPS_NO_EPOCH
+  if (hour) *hour = fix.utc.hour;
+  if (minute) *minute = fix.utc.minute;
+  if (second) *second = fix.utc.second;
+  if (hundredths) *hundredths = fix.utc.hundredths;
+#else
+  if (hour) *hour = fix.time / 1000000;
+  if (minute) *minute = (fix.time / 10000) % 100;
+  if (second) *second = (fix.time / 100) % 100;
+  if (hundredths) *hundredths = fix.time % 100;
+#endif
+  if (age) *age = fix.date_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : now() - fix.date_fix;
 }
+#endif
 
 void TinyGPS::crack_datetime(int *year, byte *month, byte *day, 
   byte *hour, byte *minute, byte *second, byte *hundredths, unsigned long *age)
 {
+#ifndef _GPS_NO_EPOCH
+  DateTime utc;
+  unsigned long time_fix;
+  byte seq;
+  do
+  {
+    seq = read_begin();
+    utc = _fix.utc;
+    time_fix = _fix.time_fix;
+  } while (read_retry(seq));
+
+  if (year) *year = utc.year;
+  if (month) *month = utc.month;
+  if (day) *day = utc.day;
+  if (hour) *hour = utc.hour;
+  if (minute) *minute = utc.minute;
+  if (second) *second = utc.second;
+  if (hundredths) *hundredths = utc.hundredths;
+  if (age) *age = time_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : now() - time_fix;
+#else
   unsigned long date, time;
   get_datetime(&date, &time, age);
   if (year) 
   {
     *year = date % 100;
-    *year += *year > 80 ? 1900 : 2000;
+    *year += *year < _GPS_CENTURY_PIVOT ? 2000 : 1900;
   }
   if (month) *month = (date / 100) % 100;
   if (day) *day = date / 10000;
@@ -623,21 +2551,70 @@ void TinyGPS::crack_datetime(int *year, byte *month, byte *day,
   if (minute) *minute = (time / 10000) % 100;
   if (second) *second = (time / 100) % 100;
   if (hundredths) *hundredths = time % 100;
+#endif
+}
+
+#ifndef _GPS_NO_EPOCH
+unsigned long TinyGPS::epoch(unsigned int *ms, unsigned long *age)
+{
+  unsigned long seconds, time_fix;
+  byte hundredths, seq;
+  do
+  {
+    seq = read_begin();
+    seconds = _fix.utc.epoch;
+    hundredths = _fix.utc.hundredths;
+    time_fix = _fix.time_fix;
+  } while (read_retry(seq));
+
+  if (ms) *ms = seconds ? 10 * hundredths : 0;
+  if (age) *age = time_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : now() - time_fix;
+  return seconds;
+}
+#endif
+
+/* static */
+unsigned long TinyGPS::epoch_seconds(unsigned int year, byte month, byte day,
+  byte hour, byte minute, byte second)
+{
+  // 2106 runs past 32 bits; 2100 is the one century year in range and not leap
+  if (year < 1970 || year > 2105 || month < 1 || month > 12 || day < 1 || day > 31 ||
+      hour > 23 || minute > 59 || second > 60)
+    return 0;
+  unsigned int years = year - 1970;
+  unsigned long days = 365UL * years + (years + 1) / 4 - (year > 2100) +
+    pgm_read_word(&_gps_days_before_month[month - 1]) + day - 1;
+  if (month > 2 && year % 4 == 0 && year != 2100)
+    ++days;
+  return days * 86400UL + hour * 3600UL + minute * 60U + second;
+}
+
+#ifndef _GPS_NO_FLOAT
+void TinyGPS::f_get_position(float *latitude, float *longitude, unsigned long *fix_age)
+{
+  long lat, lon;
+  get_position(&lat, &lon, fix_age);
+  *latitude = lat == GPS_INVALID_ANGLE ? GPS_INVALID_F_ANGLE : (lat / 1000000.0);
+  *longitude = lat == GPS_INVALID_ANGLE ? GPS_INVALID_F_ANGLE : (lon / 1000000.0);
 }
 
 float TinyGPS::f_altitude()    
 {
-  return _altitude == GPS_INVALID_ALTITUDE ? GPS_INVALID_F_ALTITUDE : _altitude / 100.0;
+  long alt = altitude();
+  return alt == GPS_INVALID_ALTITUDE ? GPS_INVALID_F_ALTITUDE : alt / 100.0;
 }
 
 float TinyGPS::f_course()
 {
-  return _course == GPS_INVALID_ANGLE ? GPS_INVALID_F_ANGLE : _course / 100.0;
+  unsigned long crs = course();
+  return crs == GPS_INVALID_ANGLE ? GPS_INVALID_F_ANGLE : crs / 100.0;
 }
 
 float TinyGPS::f_speed_knots() 
 {
-  return _speed == GPS_INVALID_SPEED ? GPS_INVALID_F_SPEED : _speed / 100.0;
+  unsigned long spd = speed();
+  return spd == GPS_INVALID_SPEED ? GPS_INVALID_F_SPEED : spd / 100.0;
 }
 
 float TinyGPS::f_speed_mph()   
@@ -661,3 +2638,4 @@ float TinyGPS::f_speed_kmph()
 const float TinyGPS::GPS_INVALID_F_ANGLE = 1000.0;
 const float TinyGPS::GPS_INVALID_F_ALTITUDE = 1000000.0;
 const float TinyGPS::GPS_INVALID_F_SPEED = -1.0;
+#endif
@@ -55,7 +55,276 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define _GPS_KMPH_PER_KNOT 1.852
 #define _GPS_MILES_PER_METER 0.00062137112
 #define _GPS_KM_PER_METER 0.001
-// #define _GPS_NO_STATS
+
+// orders the fix sequence counter against the fix data it guards
+#if defined(__AVR__)
+#define _GPS_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define _GPS_BARRIER() __sync_synchronize()
+#endif
+
+// Compile-time feature selection: uncomment (or define in the build flags)
+// to strip a feature's code and storage from every TinyGPS object
+// #define _GPS_NO_STATS  // stats(), get_stats()
+// #define _GPS_NO_GSV    // GSV satellites in view, sky(), get_sky()
+// #define _GPS_NO_GSA    // GSA satellites used in the fix, Satellites::used()
+// #define _GPS_NO_GNS    // GNS fix data, constellations()
+// #define _GPS_NO_ZDA    // ZDA date with full year, year/month/day get_datetime()
+// #define _GPS_NO_VTG    // VTG course and speed over ground
+// #define _GPS_NO_PUBX   // u-blox PUBX,00 and PUBX,04
+// #define _GPS_NO_FLOAT  // f_*() helpers, distance_between(), course_to(), cardinal()
+// #define _GPS_NO_CALLBACKS // on_fix(), on_time(), on_satellites()
+// #define _GPS_NO_SIMD   // block-at-a-time SSE2/NEON/32-bit scanning in encode()
+// #define _GPS_NO_EPOCH  // date and time decoded at commit, epoch()
+// #define _GPS_NO_UBX    // u-blox UBX binary NAV-PVT, NAV-TIMEUTC, NAV-DOP and NAV-SAT
+// #define _GPS_NO_KINEMATICS // velocity derived at commit, vertical speed, get_velocity()
+
+// Opt-in: altitude, course and HDOP terms are kept as text when a sentence
+// is parsed and converted by the first getter to ask after each commit
+// #define _GPS_LAZY_DECODE
+
+// Opt-in: positions in billionths of a degree from up to nine decimals of
+// a minute, and altitude in millimeters, for RTK receivers
+// #define _GPS_HIGH_PRECISION
+
+// Opt-in: the sentences of one UTC time, such as the GP, GL and GN
+// talkers repeating a fix, are merged and committed once when the next
+// time begins, with the position of the best source
+// #define _GPS_MERGE_EPOCHS
+
+// two-digit RMC years below this are 20yy, the rest 19yy, until a ZDA
+// sentence has given the century
+#ifndef _GPS_CENTURY_PIVOT
+#define _GPS_CENTURY_PIVOT 80
+#endif
+
+// capacity of the satellites-in-view table, at most 254
+#ifndef _GPS_MAX_SATELLITES
+#if defined(__AVR__)
+#define _GPS_MAX_SATELLITES 24
+#else
+#define _GPS_MAX_SATELLITES 64
+#endif
+#endif
+
+// longest UBX payload accepted, a NAV-SAT of 120 satellites; a header
+// announcing more is taken as a stray sync and parsed again as NMEA
+#ifndef _GPS_UBX_MAX_LENGTH
+#define _GPS_UBX_MAX_LENGTH (8 + 12 * 120)
+#endif
+
+// Satellites in view, one slot per satellite in a separate array for each
+// attribute. A (constellation, PRN) hash finds a satellite's slot in O(1).
+// generation() is odd while the table is being written and advances only
+// when its contents change, so a reader can skip a table it has already seen.
+template <byte N>
+class TinyGPSSatellites
+{
+public:
+  enum { CAPACITY = N, NONE = 0xFF };
+  // constellations, in the order of the NMEA talkers GP, GL, GA, GB/BD, GQ, GN
+  enum { GPS, GLONASS, GALILEO, BEIDOU, QZSS, MIXED };
+
+  TinyGPSSatellites() : _count(0), _generation(0) { rehash(); }
+
+  byte count() const { return _count; }
+  byte generation() const { return _generation; }
+
+  // slot i, 0 <= i < count()
+  byte prn(byte i) const { return _prn[i]; }
+  byte constellation(byte i) const { return _flags[i] & _CONSTELLATION; }
+  byte elevation(byte i) const { return _elevation[i]; } // degrees
+  uint16_t azimuth(byte i) const { return _azimuth[i]; } // degrees true
+  byte snr(byte i) const { return _snr[i]; }             // dB-Hz, 0 when not tracked
+  bool used(byte i) const { return _flags[i] & _USED; }  // in the fix solution, from GSA or NAV-SAT
+
+  // the slot of a satellite, or NONE
+  byte find(byte constellation, byte prn) const
+  {
+    for (uint16_t h = hash(constellation, prn); _hash[h] != NONE; h = next(h))
+      if (_prn[_hash[h]] == prn && (_flags[_hash[h]] & _CONSTELLATION) == constellation)
+        return _hash[h];
+    return NONE;
+  }
+
+  // a satellite as listed by GSV; flags, the constellation and ROW_USED,
+  // are only read by assign()
+  struct Row { byte prn, elevation, snr, flags; uint16_t azimuth; };
+  enum { ROW_USED = 0x80 };
+
+  // replaces a constellation's satellites with n rows of distinct PRNs,
+  // returns false, leaving the generation alone, if nothing changed;
+  // satellites it already has are kept first, and new rows beyond the
+  // capacity are dropped
+  bool replace(byte constellation, const Row *rows, byte n)
+  {
+    byte have = 0;
+    for (byte i = 0; i < _count; ++i)
+      if ((_flags[i] & _CONSTELLATION) == constellation)
+        ++have;
+    byte room = N - (_count - have); // the slots this constellation can fill
+    bool changed = have != (n < room ? n : room);
+    byte found = 0;
+    for (byte k = 0; k < n && !changed; ++k)
+    {
+      byte i = find(constellation, rows[k].prn);
+      if (i == NONE)
+        continue;
+      ++found;
+      changed = _elevation[i] != rows[k].elevation ||
+        _azimuth[i] != rows[k].azimuth || _snr[i] != rows[k].snr;
+    }
+    if (!changed && found == have)
+      return false;
+
+    begin_update();
+    // the satellites no longer listed leave before the new ones arrive, so
+    // their slots are free for them
+    for (byte i = 0; i < _count; ++i)
+      if ((_flags[i] & _CONSTELLATION) == constellation)
+        _flags[i] |= _STALE;
+    for (byte k = 0; k < n; ++k)
+    {
+      byte i = find(constellation, rows[k].prn);
+      if (i != NONE)
+        _flags[i] &= ~_STALE;
+    }
+    remove_stale();
+    for (byte k = 0; k < n; ++k)
+      set(constellation, rows[k]);
+    end_update();
+    return true;
+  }
+
+  // flags exactly the listed satellites of a constellation as used,
+  // returns false, leaving the generation alone, if nothing changed
+  bool set_used(byte constellation, const byte *prns, byte n)
+  {
+    bool changed = false;
+    for (byte i = 0; i < _count && !changed; ++i)
+      changed = (_flags[i] & _CONSTELLATION) == constellation &&
+        listed(_prn[i], prns, n) != !!(_flags[i] & _USED);
+    if (!changed)
+      return false;
+
+    begin_update();
+    for (byte i = 0; i < _count; ++i)
+      if ((_flags[i] & _CONSTELLATION) == constellation)
+        _flags[i] = listed(_prn[i], prns, n) ? _flags[i] | _USED : _flags[i] & ~_USED;
+    end_update();
+    return true;
+  }
+
+  // replaces every constellation with n rows listing all satellites in
+  // view, as a UBX NAV-SAT message does, returns false, leaving the
+  // generation alone, if nothing changed
+  bool assign(const Row *rows, byte n)
+  {
+    bool changed = n != _count;
+    for (byte k = 0; k < n && !changed; ++k)
+    {
+      byte i = find(rows[k].flags & _CONSTELLATION, rows[k].prn);
+      changed = i == NONE || _elevation[i] != rows[k].elevation ||
+        _azimuth[i] != rows[k].azimuth || _snr[i] != rows[k].snr ||
+        (_flags[i] & _USED) != (rows[k].flags & _USED);
+    }
+    if (!changed)
+      return false;
+
+    begin_update();
+    _count = 0;
+    rehash();
+    for (byte k = 0; k < n; ++k)
+    {
+      byte i = set(rows[k].flags & _CONSTELLATION, rows[k]);
+      if (i != NONE)
+        _flags[i] |= rows[k].flags & _USED;
+    }
+    end_update();
+    return true;
+  }
+
+private:
+  enum { _CONSTELLATION = 0x07, _STALE = 0x40, _USED = ROW_USED, _HASH = 2 * N };
+
+  byte _count;
+  volatile byte _generation; // a byte, like _fix_seq, so that reading it is atomic
+  byte _prn[N];
+  byte _flags[N]; // constellation, _STALE, _USED
+  byte _elevation[N];
+  uint16_t _azimuth[N];
+  byte _snr[N];
+  byte _hash[_HASH]; // slots by hash of (constellation, PRN), linear probing
+
+  void begin_update() { ++_generation; _GPS_BARRIER(); }
+  void end_update() { _GPS_BARRIER(); ++_generation; }
+
+  // adds or refreshes a satellite, returns its slot or NONE if the table is full
+  byte set(byte constellation, const Row &row)
+  {
+    byte i = find(constellation, row.prn);
+    if (i == NONE)
+    {
+      if (_count >= N)
+        return NONE;
+      i = _count++;
+      _prn[i] = row.prn;
+      _flags[i] = constellation;
+      insert(i);
+    }
+    _elevation[i] = row.elevation;
+    _azimuth[i] = row.azimuth;
+    _snr[i] = row.snr;
+    _flags[i] &= ~_STALE;
+    return i;
+  }
+
+  // drops the satellites replace() found no longer listed
+  void remove_stale()
+  {
+    byte n = 0;
+    for (byte i = 0; i < _count; ++i)
+      if (!(_flags[i] & _STALE))
+      {
+        _prn[n] = _prn[i];
+        _flags[n] = _flags[i];
+        _elevation[n] = _elevation[i];
+        _azimuth[n] = _azimuth[i];
+        _snr[n] = _snr[i];
+        ++n;
+      }
+    if (n != _count)
+    {
+      _count = n;
+      rehash();
+    }
+  }
+
+  static bool listed(byte prn, const byte *prns, byte n)
+  {
+    while (n--)
+      if (*prns++ == prn)
+        return true;
+    return false;
+  }
+
+  static uint16_t hash(byte constellation, byte prn) { return (prn + 61U * constellation) % _HASH; }
+  static uint16_t next(uint16_t h) { return h + 1 < _HASH ? h + 1 : 0; }
+  void insert(byte i)
+  {
+    uint16_t h = hash(_flags[i] & _CONSTELLATION, _prn[i]);
+    while (_hash[h] != NONE)
+      h = next(h);
+    _hash[h] = i;
+  }
+  void rehash()
+  {
+    for (uint16_t h = 0; h < _HASH; ++h)
+      _hash[h] = NONE;
+    for (byte i = 0; i < _count; ++i)
+      insert(i);
+  }
+};
 
 class TinyGPS
 {
@@ -68,123 +337,458 @@ public:
     GPS_INVALID_HDOP = 0xFFFFFFFF
   };
 
+#ifndef _GPS_NO_FLOAT
   static const float GPS_INVALID_F_ANGLE, GPS_INVALID_F_ALTITUDE, GPS_INVALID_F_SPEED;
+#endif
+
+#ifndef _GPS_NO_EPOCH
+  // date and time decoded once per sentence, when it validates
+  struct DateTime {
+    unsigned long epoch;        // seconds since 1970-01-01 UTC, 0 until date and time are known
+    unsigned int year;          // with century, 0 until a date is known
+    byte month, day, hour, minute, second, hundredths;
+  };
+#endif
+
+#ifdef _GPS_LAZY_DECODE
+  // terms whose conversion waits for a reader, empty once the field holds the value
+  struct Deferred { char altitude[10], course[7], hdop[6]; };
+#endif
+
+#ifndef _GPS_NO_KINEMATICS
+  // velocity in mm/s, derived once per commit; GPS_INVALID_SPEED if unknown
+  struct Kinematics {
+    unsigned long speed;        // over ground
+    long north, east;           // from speed and course
+    long down;                  // from PUBX,00 or NAV-PVT
+  };
+#endif
+
+  // a snapshot of the navigation data, committed whole when a sentence validates
+  struct Fix {
+    unsigned long time;         // hhmmsscc
+    unsigned long date;         // ddmmyy
+    long latitude, longitude;   // millionths of a degree
+    long altitude;              // centimeters
+#ifdef _GPS_HIGH_PRECISION
+    int64_t latitude_nano, longitude_nano; // billionths of a degree
+    long altitude_mm;
+#endif
+    unsigned long speed;        // 100ths of a knot
+#ifndef _GPS_NO_KINEMATICS
+    Kinematics velocity;
+#endif
+    unsigned long time_fix;     // now() when time was received
+    unsigned long position_fix; // now() when position was received
+#ifndef _GPS_NO_ZDA
+    unsigned long date_fix;     // now() when ZDA date was received
+    unsigned int year;
+    byte month, day;
+#endif
+#ifndef _GPS_NO_EPOCH
+    DateTime utc;
+#endif
+    uint16_t course;            // 100ths of a degree, 0xFFFF if invalid
+    uint16_t hdop;              // 100ths, 0xFFFF if invalid
+    byte numsats;
+#ifdef _GPS_LAZY_DECODE
+    Deferred text;              // always empty in a copy from get_fix()
+#endif
+  };
+
+  // bits of the changed mask passed to callbacks: the fields the sentence carried
+  enum {
+    GPS_CHANGED_TIME = 0x0001,     GPS_CHANGED_DATE = 0x0002,
+    GPS_CHANGED_POSITION = 0x0004, GPS_CHANGED_ALTITUDE = 0x0008,
+    GPS_CHANGED_SPEED = 0x0010,    GPS_CHANGED_COURSE = 0x0020,
+    GPS_CHANGED_HDOP = 0x0040,     GPS_CHANGED_SATELLITES = 0x0080,
+    GPS_CHANGED_YMD = 0x0100,      GPS_CHANGED_SKY = 0x0200,
+    GPS_CHANGED_VERTICAL = 0x0400
+  };
+  typedef void (*Callback)(TinyGPS &gps, uint16_t changed, void *context);
+  typedef unsigned long (*Clock)(void *context); // milliseconds
+
+  // sentence types, after resolving the talker
+  enum {_GPS_SENTENCE_GGA, _GPS_SENTENCE_RMC, _GPS_SENTENCE_GNS, _GPS_SENTENCE_GSA,
+      _GPS_SENTENCE_GSV, _GPS_SENTENCE_ZDA, _GPS_SENTENCE_VTG, _GPS_SENTENCE_PUBX, _GPS_SENTENCE_UBX,
+      _GPS_SENTENCE_OTHER, _GPS_SENTENCE_COUNT};  //Dan
+
+#ifndef _GPS_NO_STATS
+  struct Stats {
+    unsigned long encoded_characters;
+    unsigned long skipped_characters; // in sentences dropped by the sentence filter
+    unsigned long good_sentences;    // validated and carrying a fix
+    unsigned long passed_checksum;
+    unsigned long failed_checksum;
+    unsigned long no_fix;            // position sentences rejected for lack of fix
+    unsigned long term_truncations;  // terms too long for the staging buffer
+    unsigned long accepted[_GPS_SENTENCE_COUNT]; // passed checksum, by sentence type
+    unsigned long rejected[_GPS_SENTENCE_COUNT]; // failed checksum, by sentence type
+    unsigned int max_sentence_length; // '$' through the end of the checksum
+  };
+#endif
 
   TinyGPS();
-  bool encode(char c); // process one character received from GPS
+  // process a buffer of characters received from GPS, returns the number
+  // of sentences that were completed and validated; UBX binary frames
+  // between NMEA sentences are recognized by their sync characters
+  unsigned int encode(const char *buf, size_t len);
+  bool encode(char c) { return encode(&c, 1) != 0; } // process one character received from GPS
   TinyGPS &operator << (char c) {encode(c); return *this;}
 
+  // parse only the sentence types whose bit 1 << _GPS_SENTENCE_xxx is set
+  // in mask, all by default. Any other sentence is dropped at its first
+  // term and the parser skips to the next '$' without checksumming it.
+  // UBX frames are not filtered.
+  void set_sentence_filter(uint16_t mask) { _sentence_filter = mask; }
+  uint16_t sentence_filter() const { return _sentence_filter; }
+
+#ifdef _GPS_MERGE_EPOCHS
+  // commits the epoch being merged without waiting for the next one, for
+  // when the receiver has gone quiet
+  void end_epoch() { if (_held_changed) publish_epoch(); }
+#endif
+
+  // the clock receive times and ages are measured by, millis() unless
+  // set_clock() gives another; encode() reads it once per sentence, at
+  // its '$', and once per decoded UBX frame, at its header
+  void set_clock(Clock clock, void *context = 0) { _clock = clock; _clock_context = context; }
+  unsigned long now() { return _clock ? _clock(_clock_context) : millis(); }
+
+#ifndef _GPS_NO_CALLBACKS
+  // called from encode() after a validated sentence with a fix is committed.
+  // There is one slot: a second on_fix() replaces the first. To give the
+  // fix to several listeners, such as TinyGPSGeofence and TinyGPSHistory,
+  // register a Chain that calls each of them.
+  void on_fix(Callback cb, void *context = 0) { _on_fix.fn = cb; _on_fix.context = context; }
+  // called when time or date are committed, with or without a fix, and
+  // only then: changed is never 0. A commit with a fix calls on_time()
+  // right after on_fix() only if on_fix()'s mask has GPS_CHANGED_TIME or
+  // GPS_CHANGED_DATE, so a VTG, or a GGA or NAV-PVT without a time, is
+  // not followed by one
+  void on_time(Callback cb, void *context = 0) { _on_time.fn = cb; _on_time.context = context; }
+  // called when a complete GSV sequence or a GSA sentence changes sky()
+  void on_satellites(Callback cb, void *context = 0) { _on_satellites.fn = cb; _on_satellites.context = context; }
+
+  // up to N callbacks called in the order added, for sharing one slot:
+  //   TinyGPS::Chain<2> chain;
+  //   chain.add(Fence::on_fix, &fence);
+  //   chain.add(History::on_fix, &history);
+  //   gps.on_fix(TinyGPS::Chain<2>::call, &chain);
+  template <byte N>
+  class Chain
+  {
+  public:
+    Chain() : _count(0) {}
+    // returns false, adding nothing, if all N are taken
+    bool add(Callback cb, void *context = 0)
+    {
+      if (_count >= N)
+        return false;
+      _links[_count].fn = cb;
+      _links[_count].context = context;
+      ++_count;
+      return true;
+    }
+    // a Callback that calls every one added, context being the Chain
+    static void call(TinyGPS &gps, uint16_t changed, void *context)
+    {
+      const Chain *chain = (const Chain *)context;
+      for (byte i = 0; i < chain->_count; ++i)
+        chain->_links[i].fn(gps, changed, chain->_links[i].context);
+    }
+  private:
+    struct Link { Callback fn; void *context; };
+    Link _links[N];
+    byte _count;
+  };
+#endif
+
+  // consistent copy of the last committed fix, safe against encode()
+  // being called from an interrupt handler
+  void get_fix(Fix &fix);
+
   // lat/long in MILLIONTHs of a degree and age of fix in milliseconds
   // (note: versions 12 and earlier gave lat/long in 100,000ths of a degree.
   void get_position(long *latitude, long *longitude, unsigned long *fix_age = 0);
 
+#ifdef _GPS_HIGH_PRECISION
+  // lat/long in BILLIONTHs of a degree and age of fix in milliseconds
+  void get_position_nano(int64_t *latitude, int64_t *longitude, unsigned long *fix_age = 0);
+  // signed altitude in millimeters
+  inline long altitude_mm() { return read_fix(_fix.altitude_mm); }
+#endif
+
   // date as ddmmyy, time as hhmmsscc, and age in milliseconds
   void get_datetime(unsigned long *date, unsigned long *time, unsigned long *age = 0);
 
+#ifndef _GPS_NO_ZDA
+  // date and time from the last GPZDA sentence, age of the date in milliseconds
   void get_datetime(int *year, byte *month, byte *day, 
     byte *hour, byte *minute, byte *second, byte *hundredths = 0, unsigned long *age = 0);
+#endif
 
+#ifndef _GPS_LAZY_DECODE
   // signed altitude in centimeters (from GPGGA sentence)
-  inline long altitude() { return _altitude; }
+  inline long altitude() { return read_fix(_fix.altitude); }
 
   // course in last full GPRMC sentence in 100th of a degree
-  inline unsigned long course() { return _course; }
+  inline unsigned long course() { uint16_t c = read_fix(_fix.course); return c == 0xFFFF ? (unsigned long)GPS_INVALID_ANGLE : c; }
+#else
+  inline long altitude() { return read_parsed().altitude; }
+  inline unsigned long course() { uint16_t c = read_parsed().course; return c == 0xFFFF ? (unsigned long)GPS_INVALID_ANGLE : c; }
+#endif
 
   // speed in last full GPRMC sentence in 100ths of a knot
-  inline unsigned long speed() { return _speed; }
+  inline unsigned long speed() { return read_fix(_fix.speed); }
+
+#ifndef _GPS_NO_KINEMATICS
+  // speed over ground in mm/s
+  inline unsigned long speed_mms() { return read_fix(_fix.velocity.speed); }
+  // climb rate in mm/s, positive up
+  inline long vertical_speed() { long d = read_fix(_fix.velocity.down); return d == GPS_INVALID_SPEED ? (long)GPS_INVALID_SPEED : -d; }
+  // velocity north, east and down in mm/s
+  void get_velocity(long *north, long *east, long *down = 0);
+#endif
 
   // satellites used in last full GPGGA sentence
-  inline unsigned short satellites() { return _numsats; }
+  inline unsigned short satellites() { return _fix.numsats; }
 
   // horizontal dilution of precision in 100ths
-  inline unsigned long hdop() { return _hdop; }
+#ifndef _GPS_LAZY_DECODE
+  inline unsigned long hdop() { uint16_t h = read_fix(_fix.hdop); return h == 0xFFFF ? (unsigned long)GPS_INVALID_HDOP : h; }
+#else
+  inline unsigned long hdop() { uint16_t h = read_parsed().hdop; return h == 0xFFFF ? (unsigned long)GPS_INVALID_HDOP : h; }
+#endif
 
+#ifndef _GPS_NO_GNS
   inline char* constellations() { return _constellations; }
-  inline uint32_t* trackedSatellites() { return tracked_sat_rec; }
+#endif
+#ifndef _GPS_NO_GSV
+  typedef TinyGPSSatellites<_GPS_MAX_SATELLITES> Satellites;
+  // the satellites in view, as of the last complete GSV sequence and GSA
+  const Satellites &sky() const { return _sky; }
+  // consistent copy of sky(), safe against encode() in an interrupt handler
+  void get_sky(Satellites &sky);
+  // advances whenever sky() changes
+  byte sky_generation() const { return _sky.generation(); }
+#endif
 
-  void f_get_position(float *latitude, float *longitude, unsigned long *fix_age = 0);
   void crack_datetime(int *year, byte *month, byte *day, 
     byte *hour, byte *minute, byte *second, byte *hundredths = 0, unsigned long *fix_age = 0);
+#ifndef _GPS_NO_EPOCH
+  // seconds since 1970-01-01 UTC (0 if unknown), with the milliseconds and
+  // the age of the time in milliseconds
+  unsigned long epoch(unsigned int *ms = 0, unsigned long *age = 0);
+#endif
+  // seconds since 1970-01-01 UTC for a date in 1970..2105, 0 if the date or
+  // time is out of range (a second of 60 is taken as a leap second)
+  static unsigned long epoch_seconds(unsigned int year, byte month, byte day,
+    byte hour = 0, byte minute = 0, byte second = 0);
+  // copies the fields named by a GPS_CHANGED_* mask, and recomputes utc.epoch
+  static void copy_fields(uint16_t changed, const Fix &from, Fix &to);
+#ifndef _GPS_NO_FLOAT
+  void f_get_position(float *latitude, float *longitude, unsigned long *fix_age = 0);
   float f_altitude();
   float f_course();
   float f_speed_knots();
   float f_speed_mph();
   float f_speed_mps();
   float f_speed_kmph();
+#endif
 
   static int library_version() { return _GPS_VERSION; }
 
+  // a position in millionths of a degree, as from get_position()
+  struct Point { long latitude, longitude; };
+
+  // integer versions of distance_between() and course_to() for boards
+  // without an FPU: positions in millionths of a degree, distance in meters,
+  // course in 100ths of a degree
+  static unsigned long int_distance_between(long lat1, long long1, long lat2, long long2);
+  static unsigned int int_course_to(long lat1, long long1, long lat2, long long2);
+  // meters from one position to each of n points, into out[0..n-1]
+  static void distances_to(long lat, long lon, const Point *pts, size_t n, unsigned long *out);
+  // int_course_to() from position 1 to position 2, also storing
+  // int_distance_between() in *distance, for less than the cost of both
+  static unsigned int bearing_and_distance(long lat1, long long1, long lat2, long long2, unsigned long *distance);
+  // the nearest of 16 or 32 compass points ("N", "NbE", "NNE", ...) to a
+  // course in 100ths of a degree, as from course() or int_course_to(); ""
+  // for GPS_INVALID_ANGLE
+  static const char *int_cardinal(unsigned long course, byte points = 16);
+
+#ifndef _GPS_NO_FLOAT
   static float distance_between (float lat1, float long1, float lat2, float long2);
   static float course_to (float lat1, float long1, float lat2, float long2);
   static const char *cardinal(float course);
+#endif
 
 #ifndef _GPS_NO_STATS
   void stats(unsigned long *chars, unsigned short *good_sentences, unsigned short *failed_cs);
+  void get_stats(Stats &stats);
 #endif
 
+  // one entry of a sentence's field schema, see TinyGPS.cpp
+  struct FieldDesc { byte term; byte kind; };
+
 private:
-  enum {_GPS_SENTENCE_GPGGA, _GPS_SENTENCE_GPRMC, _GPS_SENTENCE_GNGNS, _GPS_SENTENCE_GNGSA,
-      _GPS_SENTENCE_GPGSV, _GPS_SENTENCE_GLGSV,  _GPS_SENTENCE_GPZDA, _GPS_SENTENCE_PUBX, _GPS_SENTENCE_OTHER};  //Dan
+  // in the order of the TinyGPSSatellites constellations
+  enum {_GPS_TALKER_GP, _GPS_TALKER_GL, _GPS_TALKER_GA, _GPS_TALKER_GB, _GPS_TALKER_GQ,
+      _GPS_TALKER_GN, _GPS_TALKER_OTHER};
+  // _changed bits for the partners of GPS_CHANGED_POSITION and GPS_CHANGED_YMD,
+  // cleared once the sentence validates
+  enum {_GPS_CHANGED_LONGITUDE = 0x8000, _GPS_CHANGED_MONTH = 0x4000, _GPS_CHANGED_YEAR = 0x2000};
       
   // properties
-  unsigned long _time, _new_time;
-  unsigned long _date, _new_date;
-  long _latitude, _new_latitude;
-  long _longitude, _new_longitude;
-  long _altitude, _new_altitude;
-  unsigned long  _speed, _new_speed;
-  unsigned long  _course, _new_course;
-  unsigned long  _hdop, _new_hdop;
-  unsigned short _numsats, _new_numsats;
-
-  unsigned long _last_time_fix, _new_time_fix;
-  unsigned long _last_position_fix, _new_position_fix;
-
-  unsigned long _year, _month, _day, _new_year, _new_month, _new_day;
-  unsigned long _last_date_fix, _new_date_fix;
+  volatile byte _fix_seq; // odd while _fix is being written
+  Fix _fix;     // committed
+  Fix _new;     // pending, seeded from _fix at the start of each sentence
+#ifdef _GPS_MERGE_EPOCHS
+  Fix _held;               // the epoch being merged
+  uint16_t _held_changed;  // GPS_CHANGED_* bits merged into _held, 0 if none
+  unsigned long _held_score; // source_score() of _held's position
+  byte _quality;           // fix quality rank of the current sentence
+#endif
+#ifdef _GPS_LAZY_DECODE
+  unsigned long _commits; // advanced with every commit, read under _fix_seq
+  // the deferred fields of the commit numbered commits, converted by the reader
+  struct Parsed { unsigned long commits; long altitude; uint16_t course, hdop; };
+  Parsed _parsed;
+  volatile byte _parsed_seq; // odd while _parsed is being written
+#endif
 
   // parsing state variables
+  const FieldDesc *_field; // next schema entry for the current sentence
+  uint16_t _changed;       // GPS_CHANGED_* bits of the current sentence
   byte _parity;
   bool _is_checksum_term;
-  char _term[15];
+  char _term[20]; // staging for terms split across encode() buffers
   byte _sentence_type;
-  unsigned int _UBX_message_type;
+  byte _talker;
+#ifndef _GPS_NO_PUBX
+  byte _UBX_message_type;
+#endif
   byte _term_number;
   byte _term_offset;
   bool _gps_data_good;
+  bool _in_sentence;          // from '$' to the end of the line or the sentence filter
+  unsigned long _sentence_time; // now() at the '$'
+  Clock _clock;
+  void *_clock_context;
+  uint16_t _sentence_filter;
+#ifndef _GPS_NO_EPOCH
+  byte _date_year;           // two-digit year of the current sentence's date term
+  unsigned long _epoch_date; // year, month and day whose midnight is _epoch_day
+  unsigned long _epoch_day;
+#endif
+#ifndef _GPS_NO_UBX
+  // UBX frame state, see ubx_encode()
+  byte _ubx_state;           // 0 outside a frame
+  uint16_t _ubx_message;     // class << 8 | id
+  uint16_t _ubx_length, _ubx_offset;
+  byte _ubx_ck_a, _ubx_ck_b;
+  unsigned long _ubx_value;  // the last four payload bytes, little-endian
+  unsigned long _ubx_date;   // year, month, day as in the payload
+  unsigned long _ubx_time;   // hour, minute, second and the valid bits
+  long _ubx_nano;
+  uint16_t _ubx_hdop;        // from NAV-DOP, committed with the next NAV-PVT
+  byte _ubx_sat_byte;        // offset in the current NAV-SAT satellite
+#endif
 
- struct TrackedSattelites {
-      uint8_t prn;      //"pseudo-random noise" sequences, or Gold codes. GPS sats are listed here http://en.wikipedia.org/wiki/List_of_GPS_satellites
-      uint8_t strength; //in dB
-  };
-
+#ifndef _GPS_NO_GNS
   char _constellations[6];
-  uint8_t _sat_used_count;
+#endif
 
-  //format:
-  //bit 0-7: sat ID
-  //bit 8-14: snr (dB), max 99dB
-  //bit 15: used in solution (when tracking)
-  uint32_t tracked_sat_rec[24]; //TODO: externalize array size
-  int _tracked_satellites_index;
-  uint8_t _sat_index;
+#ifndef _GPS_NO_GSV
+  Satellites _sky;
+  // a GSV sequence is staged in _gsv_rows, validated sentence by sentence,
+  // and replaces its constellation in _sky once its last message validates;
+  // 6 bytes a row
+  Satellites::Row _gsv_rows[_GPS_MAX_SATELLITES];
+  byte _gsv_total, _gsv_message; // of the current sentence
+  byte _gsv_base;                // where the current sentence's rows go
+  byte _gsv_staged;              // rows of the sequence validated so far
+  byte _gsv_next;                // message the sequence expects next, 0 if none
+  byte _gsv_constellation;
+#ifndef _GPS_NO_GSA
+  // the current GSA sentence's satellites in use and NMEA 4.10 system ID
+  byte _gsa_prns[12];
+  byte _gsa_count, _gsa_system;
+#endif
+#endif
+
+#ifndef _GPS_NO_CALLBACKS
+  struct Listener { Callback fn; void *context; };
+  Listener _on_fix, _on_time, _on_satellites;
+  // a listener is not woken for a commit that carried none of its fields
+  void notify(const Listener &l, uint16_t changed) { if (l.fn && changed) l.fn(*this, changed, l.context); }
+#endif
 
 #ifndef _GPS_NO_STATS
   // statistics
-  unsigned long _encoded_characters;
-  unsigned short _good_sentences;
-  unsigned short _failed_checksum;
-  unsigned short _passed_checksum;
+  unsigned int _sentence_length;
+  bool _filtered; // skipping the rest of a filtered sentence
+  Stats _stats;
 #endif
 
   // internal utilities
+#ifndef _GPS_LAZY_DECODE
+  void commit_begin() { ++_fix_seq; _GPS_BARRIER(); }
+#else
+  void commit_begin() { ++_fix_seq; _GPS_BARRIER(); ++_commits; }
+#endif
+  void commit_end() { _GPS_BARRIER(); ++_fix_seq; }
+  byte read_begin() { byte seq; while ((seq = _fix_seq) & 1); _GPS_BARRIER(); return seq; }
+  bool read_retry(byte seq) { _GPS_BARRIER(); return seq != _fix_seq; }
+  template <typename T> T read_fix(const T &field)
+  { T v; byte seq; do { seq = read_begin(); v = field; } while (read_retry(seq)); return v; }
+  static bool gpsisdelimiter(char c)
+  { return (unsigned char)c <= ',' && (c == ',' || c == '*' || c == '$' || c == '\r' || c == '\n'); }
+  static const char *scan_run(const char *p, const char *end, byte &parity);
+#ifdef _GPS_LAZY_DECODE
+  static bool defer_term(char *text, byte size, const char *term, byte len);
+  void parse_deferred(const Deferred &text, long &altitude, uint16_t &course, uint16_t &hdop);
+  Parsed read_parsed();
+#endif
+  void stage_term(const char *str, size_t len);
+  void settle_changed();
+#ifndef _GPS_NO_KINEMATICS
+  void settle_kinematics();
+#endif
+  bool commit_sentence();
+#ifdef _GPS_MERGE_EPOCHS
+  unsigned long source_score();
+  void hold_epoch();
+  void hold_datetime();
+  void publish_epoch();
+#endif
+#ifndef _GPS_NO_UBX
+  const char *ubx_encode(const char *p, const char *end, unsigned int &valid_sentences);
+  bool ubx_length_ok();
+  void ubx_begin();
+  void ubx_payload(byte b);
+  void ubx_datetime();
+  bool ubx_complete();
+#endif
+#ifndef _GPS_NO_GSV
+  void settle_sky();
+#endif
+#ifndef _GPS_NO_EPOCH
+  void settle_datetime();
+#endif
   int from_hex(char a);
-  unsigned long parse_decimal();
-  unsigned long parse_degrees();
-  bool term_complete();
+  unsigned long parse_decimal(const char *p, const char *end, byte decimals = 2);
+#ifndef _GPS_HIGH_PRECISION
+  unsigned long parse_degrees(const char *p, const char *end);
+#else
+  unsigned long parse_degrees(const char *p, const char *end, int64_t &nano);
+#endif
+  byte resolve_sentence_type(const char *term, byte len);
+  unsigned int parse(const char *buf, const char *end);
+  bool term_complete(const char *term, byte len);
+  static uint16_t clamp16(unsigned long v) { return v < 0xFFFF ? v : 0xFFFF; } // out of range is invalid
   bool gpsisdigit(char c) { return c >= '0' && c <= '9'; }
-  long gpsatol(const char *str);
-  int gpsstrcmp(const char *str1, const char *str2);
+  long gpsatol(const char *str, const char *end);
 };
 
 #if !defined(ARDUINO) 
@@ -0,0 +1,291 @@
+/*
+TinyGPSGeofence - a grid index of geofence zones and waypoints
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#ifndef TinyGPSGeofence_h
+#define TinyGPSGeofence_h
+
+#include "TinyGPS.h"
+
+// Zones are polygons and waypoints are points, both in millionths of a
+// degree as from get_position(). begin() lays a ROWS x COLS grid over their
+// bounding box and lists in every cell the zones whose bounding box
+// overlaps it and the waypoints that fall in it, in at most ENTRIES
+// entries in all. A lookup then tests only the zones listed in one cell
+// and searches outward from that cell for the nearest waypoint, so its
+// cost follows the local density rather than the number of zones.
+//
+// The zone and waypoint arrays are kept by pointer and must outlive the
+// index. Zones must not cross the 180th meridian; a position outside the
+// grid is in no zone and falls back to a linear waypoint search.
+//
+// To re-evaluate on every position commit:
+//   gps.on_fix(Fence::on_fix, &fence);
+// on_fix() has one slot, so this replaces any other listener, such as a
+// TinyGPSHistory. To keep both, register them in a TinyGPS::Chain.
+template <byte ROWS, byte COLS, uint16_t ENTRIES>
+class TinyGPSGeofence
+{
+public:
+  struct Zone { const TinyGPS::Point *vertices; byte count; };
+  enum { NONE = 0xFFFF };
+
+  TinyGPSGeofence()
+    :  _zones(0), _zone_count(0), _waypoints(0), _waypoint_count(0)
+    ,  _south(0), _west(0), _cell_lat(1), _cell_lon(1), _cell_meters(0)
+    ,  _zone(NONE), _waypoint(NONE), _waypoint_meters(0)
+  {
+    for (uint16_t c = 0; c <= CELLS; ++c)
+      _start[c] = _split[c] = 0;
+  }
+
+  // builds the index, returns false if the cell lists need more than
+  // ENTRIES entries (the index is then empty)
+  bool begin(const Zone *zones, uint16_t zone_count, const TinyGPS::Point *waypoints, uint16_t waypoint_count)
+  {
+    _zones = zones;
+    _zone_count = zone_count;
+    _waypoints = waypoints;
+    _waypoint_count = waypoint_count;
+    _zone = _waypoint = NONE;
+    for (uint16_t c = 0; c <= CELLS; ++c)
+      _start[c] = _split[c] = 0;
+
+    long south = 0x7FFFFFFFL, north = -0x7FFFFFFFL, west = 0x7FFFFFFFL, east = -0x7FFFFFFFL;
+    for (uint16_t z = 0; z < zone_count; ++z)
+      for (byte v = 0; v < zones[z].count; ++v)
+        grow(zones[z].vertices[v], south, north, west, east);
+    for (uint16_t w = 0; w < waypoint_count; ++w)
+      grow(waypoints[w], south, north, west, east);
+    if (south > north)
+    {
+      _south = _west = 0;
+      _cell_lat = _cell_lon = 1;
+      return true;
+    }
+    _south = south;
+    _west = west;
+    _cell_lat = (north - south) / ROWS + 1;
+    _cell_lon = (east - west) / COLS + 1;
+
+    // nothing beyond ring k of cells is nearer than k cells' narrowest
+    // side, taken on the parallel nearest a pole; 1/64 covers the great
+    // circle cutting inside the parallel
+    long edge = -south > north ? south : north;
+    unsigned long tall = TinyGPS::int_distance_between(edge, west, edge + (edge < 0 ? _cell_lat : -_cell_lat), west);
+    unsigned long wide = TinyGPS::int_distance_between(edge, west, edge, west + _cell_lon);
+    _cell_meters = tall < wide ? tall : wide;
+    _cell_meters -= _cell_meters / 64;
+
+    // count each cell's zones into _start and waypoints into _split
+    for (uint16_t z = 0; z < zone_count; ++z)
+    {
+      byte r0, c0, r1, c1;
+      if (zone_cells(zones[z], r0, c0, r1, c1))
+        for (byte r = r0; r <= r1; ++r)
+          for (byte c = c0; c <= c1; ++c)
+            ++_start[r * COLS + c];
+    }
+    for (uint16_t w = 0; w < waypoint_count; ++w)
+      ++_split[cell(waypoints[w].latitude, waypoints[w].longitude)];
+
+    // turn the counts into the end of each cell's zone and waypoint runs,
+    // then fill backwards so each run ends up starting where it should
+    uint16_t end = 0;
+    for (uint16_t c = 0; c < CELLS; ++c)
+    {
+      uint16_t z = _start[c], w = _split[c];
+      if ((unsigned long)end + z + w > ENTRIES)
+      {
+        for (c = 0; c <= CELLS; ++c)
+          _start[c] = _split[c] = 0;
+        return false;
+      }
+      _start[c] = end += z;
+      _split[c] = end += w;
+    }
+    _start[CELLS] = _split[CELLS] = end;
+    for (uint16_t z = zone_count; z-- > 0;)
+    {
+      byte r0, c0, r1, c1;
+      if (zone_cells(zones[z], r0, c0, r1, c1))
+        for (byte r = r0; r <= r1; ++r)
+          for (byte c = c0; c <= c1; ++c)
+            _entries[--_start[r * COLS + c]] = z;
+    }
+    for (uint16_t w = waypoint_count; w-- > 0;)
+      _entries[--_split[cell(waypoints[w].latitude, waypoints[w].longitude)]] = w;
+    return true;
+  }
+
+  // the lowest numbered zone containing the position, or NONE
+  uint16_t zone(long lat, long lon) const
+  {
+    uint16_t found[1];
+    return zones(lat, lon, found, 1) ? found[0] : (uint16_t)NONE;
+  }
+
+  // up to max zones containing the position into out, lowest numbered
+  // first, returns how many were found
+  byte zones(long lat, long lon, uint16_t *out, byte max) const
+  {
+    byte n = 0;
+    if (!inside_grid(lat, lon))
+      return 0;
+    uint16_t c = cell(lat, lon);
+    for (uint16_t e = _start[c]; e < _split[c] && n < max; ++e)
+      if (contains(_zones[_entries[e]], lat, lon))
+        out[n++] = _entries[e];
+    return n;
+  }
+
+  // the nearest waypoint, or NONE if there are none, and its distance
+  uint16_t nearest_waypoint(long lat, long lon, unsigned long *meters = 0) const
+  {
+    uint16_t best = NONE;
+    unsigned long best_meters = 0xFFFFFFFFUL;
+    if (!inside_grid(lat, lon))
+    {
+      for (uint16_t w = 0; w < _waypoint_count; ++w)
+        closer(w, lat, lon, best, best_meters);
+    }
+    else
+    {
+      int row = (lat - _south) / _cell_lat, col = (lon - _west) / _cell_lon;
+      for (int k = 0; ; ++k)
+      {
+        bool any = false;
+        for (int r = row - k; r <= row + k; ++r)
+        {
+          if (r < 0 || r >= ROWS)
+            continue;
+          // whole rows at the top and bottom of the ring, end cells between
+          int step = r == row - k || r == row + k ? 1 : 2 * k;
+          for (int c = col - k; c <= col + k; c += step)
+          {
+            if (c < 0 || c >= COLS)
+              continue;
+            any = true;
+            uint16_t i = r * COLS + c;
+            for (uint16_t e = _split[i]; e < _start[i + 1]; ++e)
+              closer(_entries[e], lat, lon, best, best_meters);
+          }
+        }
+        if (!any || (best != NONE && best_meters <= k * _cell_meters))
+          break;
+      }
+    }
+    if (meters)
+      *meters = best_meters;
+    return best;
+  }
+
+  // re-evaluates the zone and nearest waypoint, returns true if the zone changed
+  bool update(long lat, long lon)
+  {
+    uint16_t z = zone(lat, lon);
+    _waypoint = nearest_waypoint(lat, lon, &_waypoint_meters);
+    bool changed = z != _zone;
+    _zone = z;
+    return changed;
+  }
+
+#ifndef _GPS_NO_CALLBACKS
+  // a TinyGPS::Callback that calls update() on position commits, context
+  // being the TinyGPSGeofence
+  static void on_fix(TinyGPS &gps, uint16_t changed, void *context)
+  {
+    if (changed & TinyGPS::GPS_CHANGED_POSITION)
+    {
+      long lat, lon;
+      gps.get_position(&lat, &lon);
+      ((TinyGPSGeofence *)context)->update(lat, lon);
+    }
+  }
+#endif
+
+  // results of the last update()
+  uint16_t current_zone() const { return _zone; }
+  uint16_t current_waypoint() const { return _waypoint; }
+  unsigned long waypoint_distance() const { return _waypoint_meters; }
+
+private:
+  enum { CELLS = (uint16_t)ROWS * COLS };
+
+  const Zone *_zones;
+  uint16_t _zone_count;
+  const TinyGPS::Point *_waypoints;
+  uint16_t _waypoint_count;
+  long _south, _west, _cell_lat, _cell_lon;
+  unsigned long _cell_meters;
+  // cell c lists zones in _entries[_start[c].._split[c]) and waypoints
+  // in _entries[_split[c].._start[c + 1])
+  uint16_t _start[CELLS + 1], _split[CELLS + 1];
+  uint16_t _entries[ENTRIES ? ENTRIES : 1];
+  uint16_t _zone, _waypoint;
+  unsigned long _waypoint_meters;
+
+  static void grow(const TinyGPS::Point &p, long &south, long &north, long &west, long &east)
+  {
+    if (p.latitude < south) south = p.latitude;
+    if (p.latitude > north) north = p.latitude;
+    if (p.longitude < west) west = p.longitude;
+    if (p.longitude > east) east = p.longitude;
+  }
+
+  bool inside_grid(long lat, long lon) const
+  {
+    return lat >= _south && lon >= _west &&
+      (lat - _south) / _cell_lat < ROWS && (lon - _west) / _cell_lon < COLS;
+  }
+
+  // the cell of a position inside the grid
+  uint16_t cell(long lat, long lon) const
+  {
+    return (uint16_t)((lat - _south) / _cell_lat) * COLS + (uint16_t)((lon - _west) / _cell_lon);
+  }
+
+  // the cells a zone's bounding box covers, false for a degenerate zone
+  bool zone_cells(const Zone &zone, byte &r0, byte &c0, byte &r1, byte &c1) const
+  {
+    if (zone.count < 3)
+      return false;
+    long south = 0x7FFFFFFFL, north = -0x7FFFFFFFL, west = 0x7FFFFFFFL, east = -0x7FFFFFFFL;
+    for (byte v = 0; v < zone.count; ++v)
+      grow(zone.vertices[v], south, north, west, east);
+    r0 = (south - _south) / _cell_lat;
+    r1 = (north - _south) / _cell_lat;
+    c0 = (west - _west) / _cell_lon;
+    c1 = (east - _west) / _cell_lon;
+    return true;
+  }
+
+  // crossing-number test; the cross products need more than 32 bits
+  static bool contains(const Zone &zone, long lat, long lon)
+  {
+    bool inside = false;
+    const TinyGPS::Point *v = zone.vertices;
+    for (byte i = 0, j = zone.count - 1; i < zone.count; j = i++)
+      if ((v[i].latitude > lat) != (v[j].latitude > lat))
+      {
+        int64_t cross = (int64_t)(v[j].longitude - v[i].longitude) * (lat - v[i].latitude) -
+          (int64_t)(lon - v[i].longitude) * (v[j].latitude - v[i].latitude);
+        if ((cross > 0) == (v[j].latitude > v[i].latitude))
+          inside = !inside;
+      }
+    return inside;
+  }
+
+  void closer(uint16_t w, long lat, long lon, uint16_t &best, unsigned long &best_meters) const
+  {
+    unsigned long d = TinyGPS::int_distance_between(lat, lon, _waypoints[w].latitude, _waypoints[w].longitude);
+    if (d < best_meters)
+    {
+      best = w;
+      best_meters = d;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*
+TinyGPSHistory - the last N position fixes with rolling statistics
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#ifndef TinyGPSHistory_h
+#define TinyGPSHistory_h
+
+#include "TinyGPS.h"
+
+// A ring of the last N position fixes, N <= 255, with running sums of each
+// field and of its square kept as entries come and go, so that mean(),
+// variance() and drift() cost the same whatever N is. The sums are of the
+// difference from a reference value, which keeps them exact in 64 bits;
+// an entry more than about four degrees (or 42 km of altitude) from it
+// moves the reference there and re-adds the ring, once. Entries left that
+// far behind drop out of the sums until they leave the ring.
+//
+// Entries are appended by add(), or on every position commit with:
+//   gps.on_fix(History::on_fix, &history);
+// on_fix() has one slot, so this replaces any other listener, such as a
+// TinyGPSGeofence. To keep both, register them in a TinyGPS::Chain.
+//
+// since(t) walks the entries received at or after TinyGPS::now() time t in
+// place, oldest first:
+//   for (History::Iterator i = h.since(t).begin(); i != h.end(); ++i) ...
+template <byte N>
+class TinyGPSHistory
+{
+public:
+  // one position fix: now() when its position was received, position
+  // and altitude as from get_position() and altitude(), speed as speed()
+  struct Entry {
+    unsigned long time;
+    long latitude, longitude, altitude;
+    unsigned long speed;
+  };
+  enum Field { LATITUDE, LONGITUDE, ALTITUDE, SPEED, FIELDS };
+  enum { INVALID = TinyGPS::GPS_INVALID_ANGLE }; // as the TinyGPS invalid values
+
+  class Iterator
+  {
+  public:
+    Iterator(const TinyGPSHistory *history, byte index) : _history(history), _index(index) {}
+    const Entry &operator*() const { return (*_history)[_index]; }
+    const Entry *operator->() const { return &(*_history)[_index]; }
+    Iterator &operator++() { ++_index; return *this; }
+    bool operator==(const Iterator &other) const { return _index == other._index; }
+    bool operator!=(const Iterator &other) const { return _index != other._index; }
+  private:
+    const TinyGPSHistory *_history;
+    byte _index;
+  };
+  struct Range {
+    Iterator first, last;
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+  };
+
+  TinyGPSHistory() : _first(0), _count(0) { clear_sums(); }
+
+  static byte capacity() { return N; }
+  byte size() const { return _count; }
+  void clear() { _first = _count = 0; clear_sums(); }
+
+  // entry i, 0 the oldest and size() - 1 the newest
+  const Entry &operator[](byte i) const { return _entries[(_first + i) % N]; }
+  const Entry &newest() const { return (*this)[_count - 1]; }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, _count); }
+  // the entries received at or after now() time t
+  Range since(unsigned long t) const
+  {
+    byte lo = 0, hi = _count;
+    while (lo < hi)
+    {
+      byte mid = (lo + hi) / 2;
+      if ((long)((*this)[mid].time - t) >= 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    Range r = { Iterator(this, lo), end() };
+    return r;
+  }
+
+  // appends a fix, dropping the oldest once there are N
+  void add(const Entry &e)
+  {
+    if (_count == N)
+    {
+      remove_sums(_first);
+      _first = (_first + 1) % N;
+      --_count;
+    }
+    byte i = (_first + _count) % N;
+    _entries[i] = e;
+    ++_count;
+    if (!add_sums(i))
+      rebase();
+  }
+
+#ifndef _GPS_NO_CALLBACKS
+  // a TinyGPS::Callback that calls add() on position commits, context
+  // being the TinyGPSHistory
+  static void on_fix(TinyGPS &gps, uint16_t changed, void *context)
+  {
+    if (changed & TinyGPS::GPS_CHANGED_POSITION)
+    {
+      // one snapshot, stamped with the receive time itself rather than
+      // now() less an age measured by another clock read
+      TinyGPS::Fix fix;
+      gps.get_fix(fix);
+      Entry e;
+      e.time = fix.position_fix;
+      e.latitude = fix.latitude;
+      e.longitude = fix.longitude;
+      e.altitude = fix.altitude;
+      e.speed = fix.speed;
+      ((TinyGPSHistory *)context)->add(e);
+    }
+  }
+#endif
+
+  // entries with a valid value of the field
+  byte count(Field f) const { return _sums[f].count; }
+
+  // mean of the field over the ring, INVALID if it has no values
+  long mean(Field f) const
+  {
+    const Sum &s = _sums[f];
+    if (!s.count)
+      return INVALID;
+    int64_t sum = s.sum + (s.sum < 0 ? -(s.count / 2) : s.count / 2);
+    return s.reference + (long)(sum / s.count);
+  }
+
+  // population variance of the field, in its units squared
+  unsigned long variance(Field f) const
+  {
+    const Sum &s = _sums[f];
+    if (!s.count)
+      return 0;
+    uint64_t sum = s.sum < 0 ? -s.sum : s.sum;
+    uint64_t v = (s.squares - sum * sum / s.count) / s.count;
+    return v < 0xFFFFFFFFUL ? (unsigned long)v : 0xFFFFFFFFUL;
+  }
+
+  // change of the field per second from the oldest entry to the newest,
+  // INVALID unless both have it and were received apart
+  long drift(Field f) const
+  {
+    if (_count < 2)
+      return INVALID;
+    const Entry &a = (*this)[0], &b = newest();
+    long va = value(a, f), vb = value(b, f);
+    unsigned long ms = b.time - a.time;
+    if (va == INVALID || vb == INVALID || !ms)
+      return INVALID;
+    return (long)(((int64_t)vb - va) * 1000 / (long)ms);
+  }
+
+private:
+  enum { SPAN = 1L << 22 }; // largest difference from the reference
+
+  struct Sum {
+    long reference;
+    int64_t sum;      // of the differences from reference
+    uint64_t squares; // of their squares
+    byte count;
+  };
+
+  Entry _entries[N];
+  byte _counted[N]; // 1 << Field of the values in the sums
+  byte _first, _count;
+  Sum _sums[FIELDS];
+
+  static long value(const Entry &e, byte f)
+  {
+    switch (f)
+    {
+    case LATITUDE: return e.latitude;
+    case LONGITUDE: return e.longitude;
+    case ALTITUDE: return e.altitude == TinyGPS::GPS_INVALID_ALTITUDE ? (long)INVALID : e.altitude;
+    default: return e.speed == TinyGPS::GPS_INVALID_SPEED ? (long)INVALID : (long)e.speed;
+    }
+  }
+
+  void clear_sums()
+  {
+    for (byte f = 0; f < FIELDS; ++f)
+    {
+      _sums[f].reference = 0;
+      _sums[f].sum = 0;
+      _sums[f].squares = 0;
+      _sums[f].count = 0;
+    }
+  }
+
+  // adds entry i's values that are near enough the references to keep
+  // the sums exact, returns false if one is not
+  bool add_sums(byte i)
+  {
+    const Entry &e = _entries[i];
+    bool near = true;
+    _counted[i] = 0;
+    for (byte f = 0; f < FIELDS; ++f)
+    {
+      long v = value(e, f);
+      if (v == INVALID)
+        continue;
+      Sum &s = _sums[f];
+      if (!s.count)
+        s.reference = v;
+      int64_t d = (int64_t)v - s.reference;
+      if (d > SPAN || d < -SPAN)
+      {
+        near = false;
+        continue;
+      }
+      s.sum += d;
+      s.squares += (uint64_t)(d * d);
+      ++s.count;
+      _counted[i] |= 1 << f;
+    }
+    return near;
+  }
+
+  void remove_sums(byte i)
+  {
+    const Entry &e = _entries[i];
+    for (byte f = 0; f < FIELDS; ++f)
+      if (_counted[i] & (1 << f))
+      {
+        Sum &s = _sums[f];
+        int64_t d = (int64_t)value(e, f) - s.reference;
+        s.sum -= d;
+        s.squares -= (uint64_t)(d * d);
+        --s.count;
+      }
+  }
+
+  // moves the references to the newest entry and re-adds the ring; an
+  // entry too far from the newest is left out of the sums
+  void rebase()
+  {
+    clear_sums();
+    byte newest = (_first + _count - 1) % N;
+    add_sums(newest);
+    for (byte i = 0; i + 1 < _count; ++i)
+      add_sums((_first + i) % N);
+  }
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+TinyGPSPool - a fixed set of TinyGPS parsers for hosts with several receivers
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#ifndef TinyGPSPool_h
+#define TinyGPSPool_h
+
+#include "TinyGPS.h"
+
+// One TinyGPS per stream, fed with buffers tagged by stream id.
+// The sentence schemas, the dispatch tables and the cardinal() names are
+// static, so every parser in the pool shares them and a stream costs only
+// sizeof(TinyGPS).
+//
+// A stream's buffers must be parsed in arrival order, so a stream is the
+// unit of work. The pool creates no threads and takes no locks.
+// extras/pool/TinyGPSPoolRunner.h parses a batch on worker threads that
+// claim whole streams as they become free, so an idle worker takes the
+// streams not yet started while another is busy with a bursty port.
+// encode(chunks, count, group, groups) is the static alternative: it
+// handles the streams of one group and leaves the rest, for a caller that
+// runs one group in each of its own threads over the same batch, and
+// waits for all of them before reusing it:
+//   std::thread t([&] { pool.encode(chunks, count, 1, 2); });
+//   pool.encode(chunks, count, 0, 2);
+//   t.join();
+// Each group reads the whole batch, and a group whose stream is bursty
+// finishes last while the others wait.
+template <byte N>
+class TinyGPSPool
+{
+public:
+  // a buffer received from one stream
+  struct Chunk { byte stream; const char *buf; size_t len; };
+
+  static byte size() { return N; }
+  TinyGPS &operator[](byte stream) { return _gps[stream]; }
+
+  // process a buffer from one stream, returns the number of sentences that
+  // were completed and validated; buffers for unknown streams are ignored
+  unsigned int encode(byte stream, const char *buf, size_t len)
+  { return stream < N ? _gps[stream].encode(buf, len) : 0; }
+
+  // process interleaved chunks in order, returns the number of validated
+  // sentences. With groups > 1 only the streams with stream % groups == group
+  // are handled, so each group can be given to its own thread; 0 groups
+  // is taken as 1. A group >= groups is rejected: it handles nothing and
+  // returns GPS_INVALID_GROUP.
+  enum { GPS_INVALID_GROUP = 0xFFFF };
+  unsigned int encode(const Chunk *chunks, size_t count, byte group = 0, byte groups = 1)
+  {
+    unsigned int valid_sentences = 0;
+    if (!groups)
+      groups = 1;
+    if (group >= groups)
+      return GPS_INVALID_GROUP;
+    for (size_t i = 0; i < count; ++i)
+      if (chunks[i].stream % groups == group)
+        valid_sentences += encode(chunks[i].stream, chunks[i].buf, chunks[i].len);
+    return valid_sentences;
+  }
+
+private:
+  TinyGPS _gps[N];
+};
+
+#endif
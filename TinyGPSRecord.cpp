@@ -0,0 +1,163 @@
+/*
+TinyGPSRecord - compact delta-encoded binary records of committed fixes
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#include "TinyGPSRecord.h"
+
+static byte *_gps_put_varint(byte *p, uint32_t v)
+{
+  while (v >= 0x80)
+  {
+    *p++ = (byte)v | 0x80;
+    v >>= 7;
+  }
+  *p++ = (byte)v;
+  return p;
+}
+
+// stores the difference of two fields, which wraps like the fields do
+static byte *_gps_put_delta(byte *p, uint32_t now, uint32_t then)
+{
+  int32_t d = (int32_t)(now - then);
+  return _gps_put_varint(p, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+}
+
+// reads a varint from [p, end), returns 0 if it runs past the end
+static const byte *_gps_get_varint(const byte *p, const byte *end, uint32_t &v)
+{
+  v = 0;
+  for (byte shift = 0; shift < 35; shift += 7)
+  {
+    if (p == end)
+      return 0;
+    byte b = *p++;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      return p;
+  }
+  return 0;
+}
+
+static const byte *_gps_get_delta(const byte *p, const byte *end, uint32_t &field)
+{
+  uint32_t z;
+  p = _gps_get_varint(p, end, z);
+  if (p)
+    field += (z >> 1) ^ -(z & 1);
+  return p;
+}
+
+/* static */
+void TinyGPSRecord::clear(State &s)
+{
+  s.time = s.date = s.latitude = s.longitude = s.altitude = 0;
+  s.speed = s.course = s.hdop = 0;
+  s.numsats = 0;
+}
+
+byte TinyGPSRecordEncoder::encode(const TinyGPS::Fix &fix, byte *out)
+{
+  State now;
+  now.time = fix.time;
+  now.date = fix.date;
+  now.latitude = fix.latitude;
+  now.longitude = fix.longitude;
+  now.altitude = fix.altitude;
+  now.speed = fix.speed;
+  now.course = fix.course;
+  now.hdop = fix.hdop;
+  now.numsats = fix.numsats;
+
+  byte flags = 0, more = 0;
+  if (_key_due)
+  {
+    flags = KEY;
+    clear(_last);
+    _key_due = false;
+    _since_key = 0;
+  }
+  if (_key_interval && ++_since_key >= _key_interval)
+    _key_due = true;
+
+  if (now.time != _last.time) flags |= TIME;
+  if (now.date != _last.date) flags |= DATE;
+  if (now.latitude != _last.latitude || now.longitude != _last.longitude) flags |= POSITION;
+  if (now.altitude != _last.altitude) flags |= ALTITUDE;
+  if (now.speed != _last.speed) flags |= SPEED;
+  if (now.course != _last.course) flags |= COURSE;
+  if (now.hdop != _last.hdop) more |= HDOP;
+  if (now.numsats != _last.numsats) more |= SATELLITES;
+  if (more) flags |= MORE;
+
+  byte *p = out;
+  *p++ = flags;
+  if (flags & KEY) *p++ = VERSION;
+  if (flags & MORE) *p++ = more;
+  if (flags & TIME) p = _gps_put_delta(p, now.time, _last.time);
+  if (flags & DATE) p = _gps_put_delta(p, now.date, _last.date);
+  if (flags & POSITION)
+  {
+    p = _gps_put_delta(p, now.latitude, _last.latitude);
+    p = _gps_put_delta(p, now.longitude, _last.longitude);
+  }
+  if (flags & ALTITUDE) p = _gps_put_delta(p, now.altitude, _last.altitude);
+  if (flags & SPEED) p = _gps_put_delta(p, now.speed, _last.speed);
+  if (flags & COURSE) p = _gps_put_delta(p, now.course, _last.course);
+  if (more & HDOP) p = _gps_put_delta(p, now.hdop, _last.hdop);
+  if (more & SATELLITES) *p++ = now.numsats;
+
+  _last = now;
+  return p - out;
+}
+
+size_t TinyGPSRecordDecoder::decode(const byte *in, size_t len, TinyGPS::Fix &fix)
+{
+  const byte *p = in, *end = in + len;
+  if (p == end)
+    return 0;
+  byte flags = *p++, more = 0;
+  State s = _last;
+  if (flags & KEY)
+  {
+    if (p == end || *p++ != VERSION)
+      return 0;
+    clear(s);
+  }
+  else if (!_keyed)
+    return 0;
+  if (flags & MORE)
+  {
+    if (p == end)
+      return 0;
+    more = *p++;
+  }
+
+  if ((flags & TIME) && !(p = _gps_get_delta(p, end, s.time))) return 0;
+  if ((flags & DATE) && !(p = _gps_get_delta(p, end, s.date))) return 0;
+  if ((flags & POSITION) && !((p = _gps_get_delta(p, end, s.latitude)) &&
+      (p = _gps_get_delta(p, end, s.longitude)))) return 0;
+  if ((flags & ALTITUDE) && !(p = _gps_get_delta(p, end, s.altitude))) return 0;
+  if ((flags & SPEED) && !(p = _gps_get_delta(p, end, s.speed))) return 0;
+  if ((flags & COURSE) && !(p = _gps_get_delta(p, end, s.course))) return 0;
+  if ((more & HDOP) && !(p = _gps_get_delta(p, end, s.hdop))) return 0;
+  if (more & SATELLITES)
+  {
+    if (p == end)
+      return 0;
+    s.numsats = *p++;
+  }
+
+  _last = s;
+  _keyed = true;
+  fix.time = s.time;
+  fix.date = s.date;
+  fix.latitude = (int32_t)s.latitude;
+  fix.longitude = (int32_t)s.longitude;
+  fix.altitude = (int32_t)s.altitude;
+  fix.speed = s.speed;
+  fix.course = s.course;
+  fix.hdop = s.hdop;
+  fix.numsats = s.numsats;
+  return p - in;
+}
@@ -0,0 +1,88 @@
+/*
+TinyGPSRecord - compact delta-encoded binary records of committed fixes
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#ifndef TinyGPSRecord_h
+#define TinyGPSRecord_h
+
+#include "TinyGPS.h"
+
+// A record starts with a flags byte naming the fields that differ from the
+// previous record; only those follow, each as a zigzag varint of its
+// difference (7 bits per byte, low bits first). A fix a second after the
+// last one typically takes ten bytes or so.
+//
+// A key record is encoded against a zeroed fix and carries the format
+// version, so decoding can start at any key record. The encoder writes one
+// first, after reset() and every key_interval records; reset() before each
+// radio packet makes the packets independent of one another.
+//
+//   flags [version] [more flags] time date latitude longitude altitude
+//     speed course [hdop] [satellites]
+class TinyGPSRecord
+{
+public:
+  enum { VERSION = 1, MAX_SIZE = 40 }; // MAX_SIZE bounds any record
+
+  // flags
+  enum {
+    KEY = 0x01, TIME = 0x02, DATE = 0x04, POSITION = 0x08,
+    ALTITUDE = 0x10, SPEED = 0x20, COURSE = 0x40, MORE = 0x80
+  };
+  // more flags, in the byte after the version
+  enum { HDOP = 0x01, SATELLITES = 0x02 };
+
+protected:
+  // the recorded fields of a fix, as the 32-bit patterns the deltas wrap in
+  struct State {
+    uint32_t time, date, latitude, longitude, altitude, speed, course, hdop;
+    byte numsats;
+  };
+
+  State _last;
+
+  TinyGPSRecord() { clear(_last); }
+  static void clear(State &s);
+};
+
+class TinyGPSRecordEncoder : public TinyGPSRecord
+{
+public:
+  // key_interval 0 writes a key record only first and after reset()
+  TinyGPSRecordEncoder(uint16_t key_interval = 0)
+    :  _key_interval(key_interval), _since_key(0), _key_due(true) {}
+
+  // the next record is a key record
+  void reset() { _key_due = true; }
+
+  // writes the record of a fix, as from TinyGPS::get_fix(), into out
+  // (at least MAX_SIZE bytes) and returns its length
+  byte encode(const TinyGPS::Fix &fix, byte *out);
+  // the record of the last committed fix
+  byte encode(TinyGPS &gps, byte *out) { TinyGPS::Fix fix; gps.get_fix(fix); return encode(fix, out); }
+
+private:
+  uint16_t _key_interval, _since_key;
+  bool _key_due;
+};
+
+class TinyGPSRecordDecoder : public TinyGPSRecord
+{
+public:
+  TinyGPSRecordDecoder() : _keyed(false) {}
+
+  // forget the previous record: decoding resumes at the next key record
+  void reset() { _keyed = false; }
+
+  // reads the record at the start of in[0..len) into the recorded fields
+  // of fix, leaving its others alone, and returns the bytes it took; 0 for
+  // a truncated record, an unknown version, or a delta record without a
+  // key record before it
+  size_t decode(const byte *in, size_t len, TinyGPS::Fix &fix);
+
+private:
+  bool _keyed;
+};
+
+#endif
@@ -0,0 +1,156 @@
+/*
+TinyGPSRing - a lock-free receive ring that TinyGPS drains in bulk
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#ifndef TinyGPSRing_h
+#define TinyGPSRing_h
+
+#include "TinyGPS.h"
+#include <string.h>
+
+// A single-producer, single-consumer ring of N bytes, N a power of two.
+// The producer is a UART interrupt or a DMA completion callback and the
+// consumer is the main loop, which needs no locking: each index is written
+// by one side only, and the producer publishes its bytes before the index
+// that covers them.
+//
+// The producer either copies bytes in with write(), or lets a circular DMA
+// channel fill dma_buffer() directly and reports its position from the
+// idle-line, half-transfer and transfer-complete interrupts with
+// dma_received(). Those three arrive at least twice per lap, which
+// dma_received() needs to tell a full lap from none.
+//
+// Bytes that do not fit are dropped and counted in overruns(); a sentence
+// cut short by them fails its checksum. pending() counts the line ends
+// buffered, that is the complete sentences waiting, so the main loop can
+// drain() once per tick when there is something to parse:
+//
+//   if (ring.pending()) ring.drain(gps);
+//
+// On AVR the indices are single bytes, so they are read and written
+// atomically, and N is at most 128.
+template <uint16_t N>
+class TinyGPSRing
+{
+#if defined(__AVR__)
+  typedef byte index_t;
+#else
+  typedef unsigned int index_t;
+#endif
+  // N must be a power of two the index type can count past
+  typedef char _size_check[(N & (N - 1)) == 0 && N - 1 <= (index_t)~0 / 2 ? 1 : -1];
+
+public:
+  TinyGPSRing() : _head(0), _lines(0), _overruns(0), _tail(0), _lines_read(0) {}
+
+  static uint16_t size() { return N; }
+
+  //
+  // producer side
+  //
+
+  // bytes that write() can store now
+  uint16_t space() const { return N - (index_t)(_head - _tail); }
+
+  // stores what fits of buf and returns its length, the rest is counted
+  // in overruns()
+  uint16_t write(const char *buf, uint16_t len)
+  {
+    index_t head = _head, room = N - (index_t)(head - _tail), lines = 0;
+    uint16_t n = len < room ? len : room;
+    for (uint16_t i = 0; i < n; ++i, ++head)
+    {
+      _buf[head & (N - 1)] = buf[i];
+      lines += buf[i] == '\n';
+    }
+    publish(head, lines, len - n);
+    return n;
+  }
+  bool write(char c) { return write(&c, 1) == 1; }
+
+  // the storage for a circular DMA channel of N bytes
+  char *dma_buffer() { return _buf; }
+
+  // the DMA channel has written up to position (0..N-1) of dma_buffer();
+  // unread bytes it wrote over are counted in overruns()
+  void dma_received(uint16_t position)
+  {
+    index_t head = _head, lines = 0;
+    uint16_t n = (position - head) & (N - 1);
+    for (uint16_t i = 0; i < n; ++i)
+      lines += _buf[(head + i) & (N - 1)] == '\n';
+    index_t used = head - _tail;
+    uint16_t dropped = used + n > N ? used + n - N : 0;
+    publish(head + n, lines, dropped < n ? dropped : n);
+  }
+
+  //
+  // consumer side
+  //
+
+  // bytes buffered
+  uint16_t available() { return (index_t)(stable(_head) - _tail); }
+  // complete sentences buffered, by their line ends
+  uint16_t pending() { return (index_t)(stable(_lines) - _lines_read); }
+  // bytes dropped because the ring was full
+  unsigned long overruns() { return stable(_overruns); }
+
+  // passes everything buffered to gps.encode() in at most two runs and
+  // returns the number of sentences that were completed and validated.
+  // After a DMA overrun the ring is resynchronized by discarding it.
+  unsigned int drain(TinyGPS &gps)
+  {
+    index_t lines = stable(_lines);
+    _GPS_BARRIER();
+    index_t head = stable(_head), tail = _tail;
+    if ((index_t)(head - tail) > N)
+    {
+      _tail = head;
+      _lines_read = lines;
+      return 0;
+    }
+    unsigned int valid_sentences = 0;
+    while (tail != head)
+    {
+      uint16_t offset = tail & (N - 1), run = N - offset;
+      if ((index_t)(head - tail) < run)
+        run = head - tail;
+      const char *p = _buf + offset, *end = p + run;
+      valid_sentences += gps.encode(p, run);
+      for (; (p = (const char *)memchr(p, '\n', end - p)) != 0; ++p)
+        ++_lines_read;
+      tail += run;
+      _GPS_BARRIER();
+      _tail = tail;
+    }
+    return valid_sentences;
+  }
+
+private:
+  // head before the line count, so drain() never counts a line end it
+  // has not been given the bytes of
+  void publish(index_t head, index_t lines, uint16_t dropped)
+  {
+    _GPS_BARRIER();
+    _head = head;
+    _GPS_BARRIER();
+    _lines += lines;
+    if (dropped)
+      _overruns += dropped;
+  }
+
+  // a consistent copy of a field the interrupt may be writing
+  template <typename T> static T stable(const volatile T &v)
+  { T a; do a = v; while (a != v); return a; }
+
+  char _buf[N];
+  // written by the producer
+  volatile index_t _head, _lines;
+  volatile unsigned long _overruns;
+  // written by the consumer
+  volatile index_t _tail;
+  index_t _lines_read;
+};
+
+#endif
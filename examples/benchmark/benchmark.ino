@@ -0,0 +1,97 @@
+#include <TinyGPS.h>
+
+/* This sample code measures how fast TinyGPS parses on the target board.
+   A few recorded sentences are replayed through encode(), one character at
+   a time and as whole buffers, and the cost per sentence is reported.
+   On Cortex-M3/M4/M7 boards the DWT cycle counter is used; on everything
+   else the timing comes from micros().
+   The host-side equivalent lives in extras/bench.
+*/
+
+static const char *sentences[] = {
+  "$GPRMC,201547.000,A,3014.5527,N,09749.5808,W,0.24,163.05,040109,,*1A\r\n",
+  "$GPGGA,201548.000,3014.5529,N,09749.5808,W,1,07,1.5,225.6,M,-22.5,M,18.8,0000*78\r\n",
+  "$GPGSV,3,2,11,14,25,170,00,16,57,208,39,18,67,296,40,19,40,246,00*74\r\n",
+  "$GNGSA,A,3,16,18,22,24,,,,,,,,,1.9,1.0,1.6*2A\r\n",
+  "$PUBX,00,081350.00,4717.113210,N,00833.915187,E,546.589,G3,2.1,2.0,0.007,77.52,0.007,,0.92,1.19,0.77,9,0,0*5F\r\n",
+};
+static const int SENTENCE_COUNT = sizeof(sentences) / sizeof(sentences[0]);
+static const int PASSES = 100;
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+#define DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+static void start_counter()
+{
+  DEMCR |= 1UL << 24;  // TRCENA
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= 1;       // CYCCNTENA
+}
+static uint32_t counter() { return DWT_CYCCNT; }
+static const char *UNIT = "cycles";
+#else
+static void start_counter() {}
+static uint32_t counter() { return micros(); }
+static const char *UNIT = "us";
+#endif
+
+static uint32_t run_per_char(TinyGPS &gps, const char *str)
+{
+  uint32_t start = counter();
+  for (int pass = 0; pass < PASSES; ++pass)
+    for (const char *p = str; *p; ++p)
+      gps.encode(*p);
+  return counter() - start;
+}
+
+static uint32_t run_buffer(TinyGPS &gps, const char *str)
+{
+  size_t len = strlen(str);
+  uint32_t start = counter();
+  for (int pass = 0; pass < PASSES; ++pass)
+    gps.encode(str, len);
+  return counter() - start;
+}
+
+void setup()
+{
+  TinyGPS gps;
+  Serial.begin(115200);
+  start_counter();
+
+  Serial.print("Benchmarking TinyGPS library v. "); Serial.println(TinyGPS::library_version());
+  Serial.print("Sizeof(gpsobject) = "); Serial.println(sizeof(TinyGPS));
+  Serial.println();
+  Serial.print("Sentence  Chars  encode(c)  encode(buf)  ("); Serial.print(UNIT); Serial.println(" per sentence)");
+  Serial.println("------------------------------------------------------------");
+
+  unsigned long total_chars = 0, total_char_time = 0, total_buf_time = 0;
+  for (int i = 0; i < SENTENCE_COUNT; ++i)
+  {
+    uint32_t per_char = run_per_char(gps, sentences[i]);
+    uint32_t buffer = run_buffer(gps, sentences[i]);
+    int len = strlen(sentences[i]);
+    total_chars += (unsigned long)len * PASSES;
+    total_char_time += per_char;
+    total_buf_time += buffer;
+
+    char name[6];
+    memcpy(name, sentences[i] + 1, 5);
+    name[5] = 0;
+    char sz[64];
+    sprintf(sz, "%-8s  %5d  %9lu  %11lu", name, len,
+      (unsigned long)(per_char / PASSES), (unsigned long)(buffer / PASSES));
+    Serial.println(sz);
+  }
+
+  Serial.println();
+  Serial.print("Characters: "); Serial.println(total_chars);
+  Serial.print("encode(c) total: "); Serial.print(total_char_time); Serial.print(" "); Serial.println(UNIT);
+  Serial.print("encode(buf) total: "); Serial.print(total_buf_time); Serial.print(" "); Serial.println(UNIT);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,58 @@
+#include <TinyGPS.h>
+#include <TinyGPSRing.h>
+
+/* This sample code parses in one batch per tick instead of per byte.
+   The receiver's bytes go into a TinyGPSRing, and the main loop drains it
+   only when a complete sentence is waiting.
+   On STM32 boards built with the HAL, the ring can be filled by a circular
+   DMA channel with no per-byte interrupt at all:
+
+     HAL_UARTEx_ReceiveToIdle_DMA(&huart1, (uint8_t *)ring.dma_buffer(), ring.size());
+
+     void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
+     {
+       ring.dma_received(size % ring.size());
+     }
+
+   Elsewhere this sketch copies what the serial driver has received into the
+   ring in bulk, and assumes a 9600-baud GPS device on Serial1.
+*/
+
+TinyGPS gps;
+#if defined(__AVR__)
+TinyGPSRing<128> ring;
+#else
+TinyGPSRing<1024> ring;
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial1.begin(9600);
+}
+
+static void receive()
+{
+  char buf[32];
+  int n = Serial1.available();
+  if (n > (int)sizeof(buf))
+    n = sizeof(buf);
+  if (n > 0)
+    ring.write(buf, Serial1.readBytes(buf, n));
+}
+
+void loop()
+{
+  receive();
+  if (ring.pending())
+  {
+    unsigned int sentences = ring.drain(gps);
+    long lat, lon;
+    gps.get_position(&lat, &lon);
+    Serial.print("sentences "); Serial.print(sentences);
+    Serial.print(" lat "); Serial.print(lat);
+    Serial.print(" lon "); Serial.print(lon);
+    Serial.print(" overruns "); Serial.println(ring.overruns());
+  }
+  // the rest of the application runs here, stalls included
+}
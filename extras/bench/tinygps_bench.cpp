@@ -0,0 +1,295 @@
+/*
+TinyGPS host benchmark - replays recorded NMEA logs through TinyGPS::encode()
+and reports throughput, cost per sentence type, heap use and stack high-water.
+
+Build from the library root:
+
+  g++ -O2 -std=gnu++11 -DARDUINO=100 -Iextras/host -I. \
+    extras/bench/tinygps_bench.cpp extras/host/Arduino.cpp TinyGPS.cpp \
+    -lpthread -o tinygps_bench
+
+Run:
+
+  ./tinygps_bench [-n passes] [-m MB/s] [log.nmea ...]
+
+With no log files, extras/bench/sample.nmea is used. With -m the exit
+status is 3 if any encode() path parses slower than MB/s, so a script can
+refuse a change that costs throughput.
+*/
+
+#include "TinyGPS.h"
+
+#include <new>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycles() { return __rdtsc(); }
+#define CYCLE_UNIT "cycles"
+#else
+static inline uint64_t cycles()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#define CYCLE_UNIT "ns"
+#endif
+
+//
+// object size: the budget in README, for a 64-bit host, which bounds
+// smaller builds too; a change that needs more must raise it there
+//
+static const size_t SIZE_BUDGET = 768 + 14 * _GPS_MAX_SATELLITES
+#ifdef _GPS_MERGE_EPOCHS
+  + 192
+#endif
+#ifdef _GPS_HIGH_PRECISION
+  + 64
+#endif
+#ifdef _GPS_LAZY_DECODE
+  + 128
+#endif
+  ;
+static_assert(sizeof(TinyGPS) <= SIZE_BUDGET, "sizeof(TinyGPS) is over its budget in README");
+
+//
+// heap accounting: TinyGPS should never allocate
+//
+static volatile bool counting_allocs;
+static unsigned long allocs;
+
+void *operator new(size_t size)
+{
+  if (counting_allocs)
+    ++allocs;
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+// the default operator delete releases with free()
+
+static double now_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool load(const char *path, std::vector<char> &log)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    log.insert(log.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+struct SentenceCost
+{
+  char name[8];
+  unsigned long count;
+  uint64_t total;
+};
+
+static double slowest_mbps;
+
+static void report_throughput(const char *label, size_t bytes, double seconds, unsigned long sentences)
+{
+  double mbps = bytes / seconds / 1e6;
+  printf("%-22s %10.2f MB/s %12.0f sentences/s\n", label, mbps, sentences / seconds);
+  if (!slowest_mbps || mbps < slowest_mbps)
+    slowest_mbps = mbps;
+}
+
+static void bench_throughput(const std::vector<char> &log, int passes)
+{
+  const char *data = &log[0];
+  size_t len = log.size();
+  unsigned long sentences = 0;
+
+  TinyGPS per_byte;
+  double start = now_seconds();
+  for (int pass = 0; pass < passes; ++pass)
+    for (size_t i = 0; i < len; ++i)
+      sentences += per_byte.encode(data[i]);
+  report_throughput("encode(char)", len * passes, now_seconds() - start, sentences);
+
+  static const size_t chunks[] = { 64, 4096 };
+  for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c)
+  {
+    TinyGPS bulk;
+    sentences = 0;
+    start = now_seconds();
+    for (int pass = 0; pass < passes; ++pass)
+      for (size_t i = 0; i < len; i += chunks[c])
+        sentences += bulk.encode(data + i, len - i < chunks[c] ? len - i : chunks[c]);
+    char label[32];
+    snprintf(label, sizeof(label), "encode(buf, %u)", (unsigned)chunks[c]);
+    report_throughput(label, len * passes, now_seconds() - start, sentences);
+  }
+}
+
+// Feeds each sentence as one buffer and charges the time to its term 0
+static void bench_sentences(const std::vector<char> &log, int passes)
+{
+  std::vector<SentenceCost> costs;
+  TinyGPS gps;
+  const char *data = &log[0];
+  const char *end = data + log.size();
+
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    const char *p = data;
+    while (p < end)
+    {
+      const char *next = (const char *)memchr(p + 1, '$', end - p - 1);
+      if (!next)
+        next = end;
+
+      char name[8] = "?";
+      if (*p == '$')
+      {
+        size_t n = 0;
+        while (n < sizeof(name) - 1 && p + 1 + n < next && p[1 + n] != ',')
+          ++n;
+        memcpy(name, p + 1, n);
+        name[n] = 0;
+      }
+
+      counting_allocs = true;
+      uint64_t t0 = cycles();
+      gps.encode(p, next - p);
+      uint64_t spent = cycles() - t0;
+      counting_allocs = false;
+
+      size_t i = 0;
+      while (i < costs.size() && strcmp(costs[i].name, name))
+        ++i;
+      if (i == costs.size())
+      {
+        SentenceCost cost;
+        memcpy(cost.name, name, sizeof(name));
+        cost.count = 0;
+        cost.total = 0;
+        costs.push_back(cost);
+      }
+      ++costs[i].count;
+      costs[i].total += spent;
+      p = next;
+    }
+  }
+
+  printf("\n%-8s %10s %14s\n", "sentence", "count", CYCLE_UNIT "/sentence");
+  for (size_t i = 0; i < costs.size(); ++i)
+    printf("%-8s %10lu %14.1f\n", costs[i].name, costs[i].count,
+      (double)costs[i].total / costs[i].count);
+}
+
+//
+// stack high-water: run the parser on a painted stack and see how much of it got used
+//
+static const unsigned char STACK_PAINT = 0xA5;
+static const size_t STACK_SIZE = 256 * 1024;
+
+static void *stack_idle(void *)
+{
+  return 0;
+}
+
+static void *stack_probe(void *arg)
+{
+  const std::vector<char> *log = (const std::vector<char> *)arg;
+  TinyGPS gps;
+  for (size_t i = 0; i < log->size(); ++i)
+    gps.encode((*log)[i]);
+  gps.encode(&(*log)[0], log->size());
+  return 0;
+}
+
+static long stack_used(void *(*fn)(void *), const std::vector<char> &log)
+{
+  std::vector<unsigned char> stack(STACK_SIZE, STACK_PAINT);
+  pthread_attr_t attr;
+  pthread_t thread;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, &stack[0], stack.size());
+  int err = pthread_create(&thread, &attr, fn, (void *)&log);
+  pthread_attr_destroy(&attr);
+  if (err)
+    return -1;
+  pthread_join(thread, 0);
+
+  // stacks grow down on every host this is expected to run on
+  size_t untouched = 0;
+  while (untouched < stack.size() && stack[untouched] == STACK_PAINT)
+    ++untouched;
+  return stack.size() - untouched;
+}
+
+static void bench_stack(const std::vector<char> &log)
+{
+  long idle = stack_used(stack_idle, log);
+  long parsing = stack_used(stack_probe, log);
+  if (idle < 0 || parsing < 0)
+    printf("stack high-water: unavailable\n");
+  else
+    printf("stack high-water: %ld bytes above thread start-up\n", parsing - idle);
+}
+
+int main(int argc, char **argv)
+{
+  int passes = 200;
+  double min_mbps = 0;
+  std::vector<char> log;
+  int files = 0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      passes = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+      min_mbps = atof(argv[++i]);
+    else if (load(argv[i], log))
+      ++files;
+    else
+      return 1;
+  }
+  if (!files && !load("extras/bench/sample.nmea", log))
+    return 1;
+  if (log.empty())
+  {
+    fprintf(stderr, "empty log\n");
+    return 1;
+  }
+
+  printf("TinyGPS v. %d, sizeof(TinyGPS) = %u, log %u bytes x %d passes\n\n",
+    TinyGPS::library_version(), (unsigned)sizeof(TinyGPS), (unsigned)log.size(), passes);
+
+  counting_allocs = true;
+  bench_throughput(log, passes);
+  counting_allocs = false;
+  bench_sentences(log, passes);
+  printf("\nheap allocations during parsing: %lu\n", allocs);
+  bench_stack(log);
+  if (slowest_mbps < min_mbps)
+  {
+    printf("\nBELOW THRESHOLD: %.2f MB/s, -m %.2f\n", slowest_mbps, min_mbps);
+    return 3;
+  }
+  return 0;
+}
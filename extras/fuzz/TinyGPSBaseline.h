@@ -0,0 +1,123 @@
+/*
+TinyGPSBaseline - the version 13 parser, before the bulk encode() rewrite
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+
+A copy of the byte-at-a-time encode() and term_complete() that the
+library shipped before the bulk parser, with the getters that read what
+they commit, in namespace baseline so that it links beside the current
+TinyGPS. tinygps_fuzz.cpp diffs the current parser against it. It is
+kept as it was, bugs included: it is only fed the sentences that
+comparable() accepts, see there.
+*/
+
+#ifndef TinyGPSBaseline_h
+#define TinyGPSBaseline_h
+
+#include "TinyGPS.h"
+
+namespace baseline {
+
+class TinyGPS
+{
+public:
+  enum {
+    GPS_INVALID_AGE = 0xFFFFFFFF,      GPS_INVALID_ANGLE = 999999999,
+    GPS_INVALID_ALTITUDE = 999999999,  GPS_INVALID_DATE = 0,
+    GPS_INVALID_TIME = 0xFFFFFFFF,		 GPS_INVALID_SPEED = 999999999,
+    GPS_INVALID_FIX_TIME = 0xFFFFFFFF, GPS_INVALID_SATELLITES = 0xFF,
+    GPS_INVALID_HDOP = 0xFFFFFFFF
+  };
+
+  TinyGPS();
+  bool encode(char c); // process one character received from GPS
+
+  // lat/long in MILLIONTHs of a degree and age of fix in milliseconds
+  void get_position(long *latitude, long *longitude, unsigned long *fix_age = 0);
+
+  // date as ddmmyy, time as hhmmsscc, and age in milliseconds
+  void get_datetime(unsigned long *date, unsigned long *time, unsigned long *age = 0);
+
+  void get_datetime(int *year, byte *month, byte *day,
+    byte *hour, byte *minute, byte *second, byte *hundredths = 0, unsigned long *age = 0);
+
+  // signed altitude in centimeters (from GPGGA sentence)
+  inline long altitude() { return _altitude; }
+
+  // course in last full GPRMC sentence in 100th of a degree
+  inline unsigned long course() { return _course; }
+
+  // speed in last full GPRMC sentence in 100ths of a knot
+  inline unsigned long speed() { return _speed; }
+
+  // satellites used in last full GPGGA sentence
+  inline unsigned short satellites() { return _numsats; }
+
+  // horizontal dilution of precision in 100ths
+  inline unsigned long hdop() { return _hdop; }
+
+  void stats(unsigned long *chars, unsigned short *good_sentences, unsigned short *failed_cs);
+
+  // a tracked_sat_rec record: GPGSV satellites in 0..11, GLGSV in 12..23,
+  // 0 for an empty slot
+  uint32_t tracked_satellite(byte i) const { return tracked_sat_rec[i]; }
+
+private:
+  enum {_GPS_SENTENCE_GPGGA, _GPS_SENTENCE_GPRMC, _GPS_SENTENCE_GNGNS, _GPS_SENTENCE_GNGSA,
+      _GPS_SENTENCE_GPGSV, _GPS_SENTENCE_GLGSV,  _GPS_SENTENCE_GPZDA, _GPS_SENTENCE_PUBX, _GPS_SENTENCE_OTHER};  //Dan
+
+  // properties
+  unsigned long _time, _new_time;
+  unsigned long _date, _new_date;
+  long _latitude, _new_latitude;
+  long _longitude, _new_longitude;
+  long _altitude, _new_altitude;
+  unsigned long  _speed, _new_speed;
+  unsigned long  _course, _new_course;
+  unsigned long  _hdop, _new_hdop;
+  unsigned short _numsats, _new_numsats;
+
+  unsigned long _last_time_fix, _new_time_fix;
+  unsigned long _last_position_fix, _new_position_fix;
+
+  unsigned long _year, _month, _day, _new_year, _new_month, _new_day;
+  unsigned long _last_date_fix, _new_date_fix;
+
+  // parsing state variables
+  byte _parity;
+  bool _is_checksum_term;
+  char _term[15];
+  byte _sentence_type;
+  unsigned int _UBX_message_type;
+  byte _term_number;
+  byte _term_offset;
+  bool _gps_data_good;
+
+  char _constellations[6];
+
+  //format:
+  //bit 0-7: sat ID
+  //bit 8-14: snr (dB), max 99dB
+  //bit 15: used in solution (when tracking)
+  uint32_t tracked_sat_rec[24]; //TODO: externalize array size
+  int _tracked_satellites_index;
+  uint8_t _sat_index;
+
+  // statistics
+  unsigned long _encoded_characters;
+  unsigned short _good_sentences;
+  unsigned short _failed_checksum;
+  unsigned short _passed_checksum;
+
+  // internal utilities
+  int from_hex(char a);
+  unsigned long parse_decimal();
+  unsigned long parse_degrees();
+  bool term_complete();
+  bool gpsisdigit(char c) { return c >= '0' && c <= '9'; }
+  long gpsatol(const char *str);
+  int gpsstrcmp(const char *str1, const char *str2);
+};
+
+} // namespace baseline
+
+#endif
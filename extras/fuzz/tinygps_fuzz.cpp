@@ -0,0 +1,662 @@
+/*
+tinygps_fuzz - fuzzing entry point and differential check for TinyGPS::encode()
+
+Every input is parsed three ways: one byte at a time through
+encode(char); in buffers of varying length through encode(buf, len); and
+through a TinyGPSRing drained in bulk. All three use the same
+sentence-counting clock. They must validate the same sentences, commit the
+same fixes in the same order, and end with the same statistics and
+satellite table. The input is then parsed the same three ways again with a
+sentence filter. This only shows that the result does not depend on how
+the input is split, since all three share term_complete().
+
+What the values should be comes from the version 13 parser vendored in
+TinyGPSBaseline.cpp. Every sentence that comparable() accepts is fed to
+both one byte at a time, and the position, time, date, altitude, speed,
+course, HDOP, satellite count and statistics must agree after each one.
+After each complete GPGSV or GLGSV sequence, the baseline's tracked
+satellites must also match sky(). Under _GPS_MERGE_EPOCHS each sentence
+is ended as an epoch before the comparison. The sentences it rejects are
+those the library has since changed on purpose; the list is above
+comparable(). Any difference aborts, so a fuzzer reports it as a crash.
+
+libFuzzer, from the library root:
+
+  clang++ -g -O1 -std=gnu++11 -fsanitize=fuzzer,address,undefined \
+    -DTINYGPS_LIBFUZZER -DARDUINO=100 -Iextras/host -I. \
+    extras/fuzz/tinygps_fuzz.cpp extras/replay/TinyGPSReplay.cpp \
+    extras/fuzz/TinyGPSBaseline.cpp extras/host/Arduino.cpp TinyGPS.cpp \
+    -pthread -o tinygps_fuzz
+  ./tinygps_fuzz corpus/
+
+AFL and plain runs use the main() below. It checks each file named, or
+stdin if none are:
+
+  afl-clang-fast++ -O2 -std=gnu++11 -DARDUINO=100 ... -o tinygps_fuzz
+  afl-fuzz -i corpus -o findings ./tinygps_fuzz @@
+
+  g++ -O2 -std=gnu++11 -DARDUINO=100 -Iextras/host -I. \
+    extras/fuzz/tinygps_fuzz.cpp extras/replay/TinyGPSReplay.cpp \
+    extras/fuzz/TinyGPSBaseline.cpp extras/host/Arduino.cpp TinyGPS.cpp \
+    -pthread -o tinygps_fuzz
+  ./tinygps_fuzz extras/bench/sample.nmea
+
+extras/bench/sample.nmea makes a good seed corpus. Build again with
+-D_GPS_LAZY_DECODE, -D_GPS_MERGE_EPOCHS, -D_GPS_NO_SIMD, -D_GPS_NO_UBX
+and so on to check those variants.
+*/
+
+#include "../replay/TinyGPSReplay.h"
+#include "TinyGPSBaseline.h"
+#include "TinyGPSRing.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Commit
+{
+  uint16_t changed;
+  bool fix; // from on_fix(), else on_time()
+  TinyGPS::Fix state;
+};
+
+struct Run
+{
+  std::vector<Commit> commits;
+  unsigned long clock;
+  unsigned long sentences;
+  unsigned long sky_changes;
+};
+
+static void record(TinyGPS &gps, uint16_t changed, bool fix, Run *run)
+{
+  Commit commit;
+  commit.changed = changed;
+  commit.fix = fix;
+  gps.get_fix(commit.state);
+  run->commits.push_back(commit);
+}
+
+static void record_fix(TinyGPS &gps, uint16_t changed, void *context)
+{
+  record(gps, changed, true, (Run *)context);
+}
+
+static void record_time(TinyGPS &gps, uint16_t changed, void *context)
+{
+  record(gps, changed, false, (Run *)context);
+}
+
+static void record_satellites(TinyGPS &, uint16_t, void *context)
+{
+  ++((Run *)context)->sky_changes;
+}
+
+static void start(TinyGPS &gps, Run &run, uint16_t filter)
+{
+  run.clock = 0;
+  run.sentences = 0;
+  run.sky_changes = 0;
+  gps.set_clock(TinyGPSReplay::count_clock, &run.clock);
+  gps.set_sentence_filter(filter);
+  gps.on_fix(record_fix, &run);
+  gps.on_time(record_time, &run);
+  gps.on_satellites(record_satellites, &run);
+}
+
+// buffer lengths from 1 to 2048, mostly short, the same for every run
+// over an input
+static size_t next_length(uint32_t &state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return (state >> 8) % (state & 1 ? 2048 : 16) + 1;
+}
+
+static void parse_bytes(TinyGPS &gps, Run &run, const char *data, size_t len)
+{
+  for (size_t i = 0; i < len; ++i)
+    run.sentences += gps.encode(data[i]);
+}
+
+static void parse_buffers(TinyGPS &gps, Run &run, const char *data, size_t len)
+{
+  uint32_t state = 2463534242UL;
+  for (size_t i = 0; i < len; )
+  {
+    size_t n = next_length(state);
+    if (n > len - i)
+      n = len - i;
+    run.sentences += gps.encode(data + i, n);
+    i += n;
+  }
+}
+
+static void parse_ring(TinyGPS &gps, Run &run, const char *data, size_t len)
+{
+  TinyGPSRing<512> ring;
+  uint32_t state = 2463534242UL;
+  for (size_t i = 0; i < len; )
+  {
+    size_t n = next_length(state);
+    if (n > len - i)
+      n = len - i;
+    if (n > ring.space())
+      n = ring.space();
+    i += ring.write(data + i, n);
+    if (ring.pending() || !ring.space())
+      run.sentences += ring.drain(gps);
+  }
+  run.sentences += ring.drain(gps);
+}
+
+#ifndef _GPS_NO_GSV
+static bool same_sky(const TinyGPS::Satellites &a, const TinyGPS::Satellites &b)
+{
+  if (a.count() != b.count() || a.generation() != b.generation())
+    return false;
+  for (byte i = 0; i < a.count(); ++i)
+    if (a.prn(i) != b.prn(i) || a.constellation(i) != b.constellation(i) ||
+      a.elevation(i) != b.elevation(i) || a.azimuth(i) != b.azimuth(i) ||
+      a.snr(i) != b.snr(i) || a.used(i) != b.used(i))
+      return false;
+  return true;
+}
+#endif
+
+static void mismatch(const char *path, const char *what, uint16_t filter, const char *detail)
+{
+  fprintf(stderr, "MISMATCH: %s, %s with filter 0x%04X: %s\n", path, what, filter, detail);
+  abort();
+}
+
+static void compare(TinyGPS &ref, const Run &ref_run, TinyGPS &gps, const Run &run,
+  const char *path, const char *what, uint16_t filter)
+{
+  if (run.sentences != ref_run.sentences)
+    mismatch(path, what, filter, "validated sentences");
+  if (run.commits.size() != ref_run.commits.size())
+    mismatch(path, what, filter, "number of commits");
+  for (size_t i = 0; i < run.commits.size(); ++i)
+  {
+    const Commit &a = ref_run.commits[i], &b = run.commits[i];
+    if (a.changed != b.changed || a.fix != b.fix || !TinyGPSReplay::same_fix(a.state, b.state))
+      mismatch(path, what, filter, "commit");
+  }
+  TinyGPS::Fix a, b;
+  ref.get_fix(a);
+  gps.get_fix(b);
+  if (!TinyGPSReplay::same_fix(a, b))
+    mismatch(path, what, filter, "last fix");
+#ifndef _GPS_NO_STATS
+  TinyGPS::Stats sa, sb;
+  memset(&sa, 0, sizeof(sa));
+  memset(&sb, 0, sizeof(sb));
+  ref.get_stats(sa);
+  gps.get_stats(sb);
+  if (memcmp(&sa, &sb, sizeof(sa)))
+    mismatch(path, what, filter, "statistics");
+#endif
+#ifndef _GPS_NO_GSV
+  if (run.sky_changes != ref_run.sky_changes || !same_sky(ref.sky(), gps.sky()))
+    mismatch(path, what, filter, "satellite table");
+#endif
+}
+
+// parses the input each way and returns the reference's commits
+static size_t check(const char *path, const char *data, size_t len, uint16_t filter)
+{
+  TinyGPS ref, bulk, ringed;
+  Run ref_run, bulk_run, ring_run;
+  start(ref, ref_run, filter);
+  start(bulk, bulk_run, filter);
+  start(ringed, ring_run, filter);
+  parse_bytes(ref, ref_run, data, len);
+  parse_buffers(bulk, bulk_run, data, len);
+  parse_ring(ringed, ring_run, data, len);
+#ifdef _GPS_MERGE_EPOCHS
+  ref.end_epoch();
+  bulk.end_epoch();
+  ringed.end_epoch();
+#endif
+  compare(ref, ref_run, bulk, bulk_run, path, "encode(buf, len)", filter);
+  compare(ref, ref_run, ringed, ring_run, path, "TinyGPSRing", filter);
+  return ref_run.commits.size();
+}
+
+// The baseline differential. The version 13 parser in TinyGPSBaseline
+// commits different fields, for fewer sentence types, and keeps an empty
+// term's value from whatever sentence last had one, so the two are only
+// compared on sentences both are meant to read alike. comparable() picks
+// those out, leaving out each of the intended changes:
+//   - sentences other than GPRMC, GNRMC, GPGGA, GPZDA, GPGSV and GLGSV,
+//     which only the current parser reads for other talkers or commits at
+//     all, GPZDA under _GPS_NO_ZDA, and GSV under _GPS_NO_GSV;
+//   - an empty term where the schema reads one, which the baseline fills
+//     from the last sentence that had it, even a rejected one;
+//   - a term over 14 characters, which the baseline truncates;
+//   - a time shorter than hhmmss or not a time of day, and an RMC date
+//     shorter than ddmmyy or not a date, which the current parser takes
+//     as unreadable;
+//   - a negative course or HDOP, or one of 655.35 or more, which the
+//     current parser holds in 16 bits;
+//   - a satellite count with a sign or leading blanks, which atoi() read
+//     and the in-place parser does not, or of more than 9 digits, on which
+//     atoi() overflows;
+//   - a NUL, which ends a baseline term early, and a '\r' before the end
+//     of the line, which ends the current parser's sentence;
+//   - a GSV message with a bad checksum, which the baseline applies term
+//     by term before checking it; one of a sequence of more than 3
+//     messages, which runs past the baseline's 12 slots; a satellite whose
+//     PRN is not 1 to 255 or repeats one already in the sequence, unless
+//     its PRN and SNR are both empty; and an SNR that is not empty or 0
+//     to 99.
+// The baseline writes each GSV message into its table at once, and the
+// current parser publishes a sequence when its last message arrives, so
+// the satellite tables are only compared then. Under _GPS_MERGE_EPOCHS
+// each comparable sentence is ended as an epoch of its own with
+// end_epoch() before the fixes are compared; how several sentences of one
+// epoch are merged is checked only between the three encode() paths.
+
+// what parse_decimal() reads of a term, in hundredths
+static unsigned long hundredths(const char *p, const char *end)
+{
+  unsigned long v = 0;
+  for (; p < end && isdigit((unsigned char)*p); ++p)
+    if (v < 100000UL)
+      v = 10 * v + (*p - '0');
+  v *= 100;
+  if (p < end && *p == '.' && ++p < end && isdigit((unsigned char)*p))
+  {
+    v += 10 * (*p - '0');
+    if (++p < end && isdigit((unsigned char)*p))
+      v += *p - '0';
+  }
+  return v;
+}
+
+// the constellations' values are the TinyGPS::Satellites ones
+enum { GPGSV, GLGSV, RMC, GGA, ZDA, NONE };
+
+// whether the term starts with three two-digit numbers below the limits,
+// each at least its minimum
+static bool two_digit_fields(const char *p, size_t len, const byte *min, const byte *limit)
+{
+  if (len < 6)
+    return false;
+  for (byte i = 0; i < 3; ++i, p += 2)
+  {
+    if (!isdigit((unsigned char)p[0]) || !isdigit((unsigned char)p[1]))
+      return false;
+    byte v = 10 * (p[0] - '0') + (p[1] - '0');
+    if (v < min[i] || v >= limit[i])
+      return false;
+  }
+  return true;
+}
+
+// term n of a sentence of the type, from 1
+static bool comparable_term(byte type, unsigned int n, const char *p, const char *end)
+{
+  static const byte time_min[] = { 0, 0, 0 }, time_limit[] = { 24, 60, 61 };
+  static const byte date_min[] = { 1, 1, 0 }, date_limit[] = { 32, 13, 100 };
+  size_t len = end - p;
+  if (len > 14)
+    return false;
+  if (n > (type == ZDA ? 4U : 9U))
+    return true;
+  if (!len)
+    return false;
+  if (n == 1)
+    return two_digit_fields(p, len, time_min, time_limit);
+  if (type == RMC && n == 9)
+    return two_digit_fields(p, len, date_min, date_limit);
+  if (type != ZDA && n == 8) // course, HDOP
+    return *p != '-' && hundredths(p, end) < 0xFFFF;
+  if (type == GGA && n == 7)
+    return isdigit((unsigned char)*p) && len <= 9;
+  return true;
+}
+
+#ifndef _GPS_NO_GSV
+// the GSV sequence being staged, followed as the current parser follows
+// it: a first message starts one, and anything but the next message of
+// the same constellation abandons it
+struct Sequence
+{
+  byte constellation, next, count;
+  byte prns[12];
+};
+
+// a GSV message and the PRNs of its satellites
+struct Message
+{
+  byte number, total, count;
+  byte prns[4];
+};
+
+// the value of a term of 1 to 3 digits, or -1
+static int small_number(const char *p, const char *end)
+{
+  if (p >= end || end - p > 3)
+    return -1;
+  int v = 0;
+  for (; p < end; ++p)
+  {
+    if (!isdigit((unsigned char)*p))
+      return -1;
+    v = 10 * v + (*p - '0');
+  }
+  return v;
+}
+
+// whether the GSV message [p, end), whose first comma and '*' are at
+// comma and star, is one both parsers read alike
+static bool comparable_gsv(byte constellation, const char *p, const char *end,
+  const char *comma, const char *star, const Sequence &seq, Message &m)
+{
+  byte checksum = 0;
+  for (const char *q = p + 1; q < star; ++q)
+    checksum ^= *q;
+  static const char hex[] = "0123456789ABCDEF";
+  if (end - star < 4 || (star[3] != '\r' && star[3] != '\n') ||
+      toupper((unsigned char)star[1]) != hex[checksum >> 4] ||
+      toupper((unsigned char)star[2]) != hex[checksum & 15])
+    return false;
+
+  const char *terms[24];
+  byte n = 0;
+  for (const char *q = comma; q && n < 24; )
+  {
+    terms[n++] = q + 1;
+    q = (const char *)memchr(q + 1, ',', star - q - 1);
+  }
+  if (n < 3 || n == 24)
+    return false;
+  terms[n] = star + 1; // one past the last term's terminator
+#define TERM_END(i) (terms[(i) + 1] - 1)
+  int total = small_number(terms[0], TERM_END(0));
+  int number = small_number(terms[1], TERM_END(1));
+  if (total < 1 || total > 3 || number < 1 || number > total)
+    return false;
+  m.total = total;
+  m.number = number;
+  m.count = 0;
+  bool continues = number > 1 && seq.next == number && seq.constellation == constellation;
+  for (byte q = 0; q < 4 && 3 + 4 * (q + 1) <= n; ++q)
+  {
+    byte t = 3 + 4 * q;
+    bool no_snr = terms[t + 3] == TERM_END(t + 3);
+    if (no_snr && terms[t] == TERM_END(t))
+      continue; // padding, which neither keeps
+    int prn = small_number(terms[t], TERM_END(t));
+    int snr = no_snr ? 0 : small_number(terms[t + 3], TERM_END(t + 3));
+    if (prn < 1 || prn > 255 || snr < 0 || snr > 99)
+      return false;
+    for (byte i = 0; i < m.count; ++i)
+      if (m.prns[i] == prn)
+        return false;
+    for (byte i = 0; continues && i < seq.count; ++i)
+      if (seq.prns[i] == prn)
+        return false;
+    m.prns[m.count++] = prn;
+  }
+#undef TERM_END
+  return true;
+}
+
+// follows the sequence with a message both parsers were fed, returns true
+// if it completed the sequence
+static bool follow(Sequence &seq, byte constellation, const Message &m)
+{
+  if (m.number == 1)
+  {
+    seq.constellation = constellation;
+    seq.next = 1;
+    seq.count = 0;
+  }
+  if (!seq.next || m.number != seq.next || constellation != seq.constellation)
+  {
+    seq.next = 0;
+    return false;
+  }
+  memcpy(seq.prns + seq.count, m.prns, m.count);
+  seq.count += m.count;
+  if (m.number == m.total)
+  {
+    seq.next = 0;
+    return true;
+  }
+  ++seq.next;
+  return false;
+}
+
+// The baseline keeps a tracked satellite as PRN << 8 | SNR << 1 in the
+// constellation's 12 slots, and a satellite with no SNR not at all. Its
+// GSA case is empty, so it never sets the used bit its comment places at
+// bit 15, where the PRN's top bit is. Each of its records must then be a
+// row of sky() with the same PRN and SNR that is not used(), and sky()
+// must have no other row of the constellation with an SNR.
+static bool same_satellites(baseline::TinyGPS &old, const TinyGPS::Satellites &sky, byte constellation)
+{
+  byte tracked = 0, records = 0;
+  for (byte i = 0; i < sky.count(); ++i)
+    if (sky.constellation(i) == constellation && sky.snr(i))
+      ++tracked;
+  for (byte k = 0; k < 12; ++k)
+  {
+    uint32_t rec = old.tracked_satellite(12 * constellation + k);
+    if (!rec)
+      continue;
+    ++records;
+    byte i = sky.find(constellation, rec >> 8);
+    if (i == TinyGPS::Satellites::NONE || sky.snr(i) != (rec >> 1 & 0x7F) || sky.used(i))
+      return false;
+  }
+  return records == tracked;
+}
+#endif
+
+// the type of the sentence [p, end), from '$' through '\n', if it is one
+// both parsers read alike, else NONE
+static byte comparable(const char *p, const char *end
+#ifndef _GPS_NO_GSV
+  , const Sequence &seq, Message &m
+#endif
+  )
+{
+  const char *star = 0;
+  for (const char *q = p + 1; q + 1 < end; ++q)
+  {
+    if (!*q || *q == '$' || (*q == '\r' && q + 2 != end))
+      return NONE;
+    if (*q == '*' && !star)
+      star = q;
+  }
+  if (!star)
+    return NONE;
+  const char *term = p + 1, *comma = (const char *)memchr(term, ',', star - term);
+  if (!comma)
+    return NONE;
+  byte type;
+  size_t len = comma - term;
+  if (len == 5 && (!memcmp(term, "GPRMC", 5) || !memcmp(term, "GNRMC", 5)))
+    type = RMC;
+  else if (len == 5 && !memcmp(term, "GPGGA", 5))
+    type = GGA;
+#ifndef _GPS_NO_ZDA
+  else if (len == 5 && !memcmp(term, "GPZDA", 5))
+    type = ZDA;
+#endif
+#ifndef _GPS_NO_GSV
+  else if (len == 5 && (!memcmp(term, "GPGSV", 5) || !memcmp(term, "GLGSV", 5)))
+  {
+    type = term[1] == 'P' ? GPGSV : GLGSV;
+    return comparable_gsv(type, p, end, comma, star, seq, m) ? type : NONE;
+  }
+#endif
+  else
+    return NONE;
+  for (unsigned int n = 1; ; ++n)
+  {
+    term = comma + 1;
+    comma = (const char *)memchr(term, ',', star - term);
+    if (!comparable_term(type, n, term, comma ? comma : star))
+      return NONE;
+    if (!comma)
+      return n >= (type == ZDA ? 4U : 9U) ? type : NONE;
+  }
+}
+
+static void differ(const char *path, const char *p, const char *end, const char *detail)
+{
+  fprintf(stderr, "MISMATCH: %s, baseline: %s after %.*s", path, detail, (int)(end - p), p);
+  abort();
+}
+
+// parses the comparable sentences of the input with the baseline and the
+// current parser, and returns how many there were
+static size_t check_baseline(const char *path, const char *data, size_t len)
+{
+  baseline::TinyGPS old;
+  TinyGPS gps;
+  unsigned long clock = 0;
+  gps.set_clock(TinyGPSReplay::count_clock, &clock);
+#ifndef _GPS_NO_GSV
+  Sequence seq;
+  seq.next = 0;
+  Message m;
+#endif
+  size_t sentences = 0;
+  const char *end = data + len;
+  for (const char *p = (const char *)memchr(data, '$', len); p; p = (const char *)memchr(p, '$', end - p))
+  {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    if (!eol)
+      break;
+    const char *next = eol + 1;
+    byte type = comparable(p, next
+#ifndef _GPS_NO_GSV
+      , seq, m
+#endif
+      );
+    if (type == NONE)
+    {
+      p = next;
+      continue;
+    }
+    ++sentences;
+    unsigned int old_valid = 0, valid = 0;
+    for (const char *q = p; q < next; ++q)
+    {
+      old_valid += old.encode(*q);
+      valid += gps.encode(*q);
+    }
+#ifdef _GPS_MERGE_EPOCHS
+    gps.end_epoch();
+#endif
+    if (old_valid != valid)
+      differ(path, p, next, "validated sentences");
+#ifndef _GPS_NO_GSV
+    if (type <= GLGSV && follow(seq, type, m) && !same_satellites(old, gps.sky(), type))
+      differ(path, p, next, "satellite table");
+#endif
+    long lat[2], lon[2];
+    old.get_position(&lat[0], &lon[0]);
+    gps.get_position(&lat[1], &lon[1]);
+    if (lat[0] != lat[1] || lon[0] != lon[1])
+      differ(path, p, next, "position");
+    unsigned long date[2], time[2];
+    old.get_datetime(&date[0], &time[0]);
+    gps.get_datetime(&date[1], &time[1]);
+    if (date[0] != date[1] || time[0] != time[1])
+      differ(path, p, next, "date and time");
+    if (old.altitude() != gps.altitude())
+      differ(path, p, next, "altitude");
+    if (old.speed() != gps.speed())
+      differ(path, p, next, "speed");
+    if (old.course() != gps.course())
+      differ(path, p, next, "course");
+    if (old.hdop() != gps.hdop())
+      differ(path, p, next, "hdop");
+    if (old.satellites() != gps.satellites())
+      differ(path, p, next, "satellites");
+#ifndef _GPS_NO_ZDA
+    int year[2];
+    byte month[2], day[2], hour, minute, second;
+    old.get_datetime(&year[0], &month[0], &day[0], &hour, &minute, &second);
+    gps.get_datetime(&year[1], &month[1], &day[1], &hour, &minute, &second);
+    if (year[0] != year[1] || month[0] != month[1] || day[0] != day[1])
+      differ(path, p, next, "ZDA date");
+#endif
+#ifndef _GPS_NO_STATS
+    unsigned long chars[2];
+    unsigned short good[2], failed[2];
+    old.stats(&chars[0], &good[0], &failed[0]);
+    gps.stats(&chars[1], &good[1], &failed[1]);
+    if (chars[0] != chars[1] || good[0] != good[1] || failed[0] != failed[1])
+      differ(path, p, next, "statistics");
+#endif
+    p = next;
+  }
+  return sentences;
+}
+
+static const uint16_t FILTERED = 1 << TinyGPS::_GPS_SENTENCE_GGA |
+  1 << TinyGPS::_GPS_SENTENCE_RMC | 1 << TinyGPS::_GPS_SENTENCE_GSV;
+
+static size_t check_input(const char *path, const char *data, size_t len, size_t *compared)
+{
+  size_t commits = check(path, data, len, 0xFFFF);
+  check(path, data, len, FILTERED);
+  *compared = check_baseline(path, data, len);
+  return commits;
+}
+
+#ifdef TINYGPS_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  size_t compared;
+  check_input("input", (const char *)data, size, &compared);
+  return 0;
+}
+
+#else
+
+static bool load(FILE *f, std::vector<char> &input)
+{
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    input.insert(input.end(), buf, buf + n);
+  return !ferror(f);
+}
+
+int main(int argc, char **argv)
+{
+  for (int i = argc > 1 ? 1 : 0; i < argc; ++i)
+  {
+    const char *path = i ? argv[i] : "stdin";
+    FILE *f = i ? fopen(path, "rb") : stdin;
+    std::vector<char> input;
+    if (!f || !load(f, input))
+    {
+      perror(path);
+      return 1;
+    }
+    if (i)
+      fclose(f);
+    size_t compared;
+    size_t commits = check_input(path, input.empty() ? "" : &input[0], input.size(), &compared);
+    printf("%s: %u bytes, %u commits identical, %u sentences as the baseline\n",
+      path, (unsigned)input.size(), (unsigned)commits, (unsigned)compared);
+  }
+  return 0;
+}
+
+#endif
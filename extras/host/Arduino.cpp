@@ -0,0 +1,20 @@
+/*
+Host implementation of the Arduino timing functions used by TinyGPS.
+*/
+
+#include "Arduino.h"
+#include <time.h>
+
+static uint64_t host_now_us()
+{
+  static uint64_t start;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t now = (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+  if (!start)
+    start = now;
+  return now - start;
+}
+
+unsigned long millis() { return (unsigned long)(host_now_us() / 1000); }
+unsigned long micros() { return (unsigned long)host_now_us(); }
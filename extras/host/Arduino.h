@@ -0,0 +1,39 @@
+/*
+Minimal Arduino.h replacement so TinyGPS can be compiled and run on a
+desktop host (benchmarks, log replay). Only what TinyGPS itself uses is
+provided. Build with -DARDUINO=100 and this directory on the include path.
+*/
+
+#ifndef TinyGPS_host_Arduino_h
+#define TinyGPS_host_Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+#define sq(x) ((x)*(x))
+
+// milliseconds/microseconds since the first call, from a monotonic clock
+unsigned long millis();
+unsigned long micros();
+
+#endif
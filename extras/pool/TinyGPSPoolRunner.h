@@ -0,0 +1,115 @@
+/*
+TinyGPSPoolRunner - parses a TinyGPSPool batch on worker threads on hosts
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+
+A stream's buffers must be parsed in order, so a stream is the unit of
+work. run() sorts the batch by stream once, keeping each stream's chunks
+in arrival order, then lets the workers claim whole streams from an atomic
+counter. A worker that finishes early takes the next unclaimed stream, so
+one bursty port keeps one thread busy while the others share the rest.
+Streams are handed out largest first, so a burst is started before the
+small streams rather than after them. The batch is walked once, whatever
+the number of threads.
+
+Header only, as TinyGPSPool is a template. Build with the library and the
+host shim, C++11 and -pthread, see tinygps_pool.cpp.
+*/
+
+#ifndef TinyGPSPoolRunner_h
+#define TinyGPSPoolRunner_h
+
+#include "TinyGPSPool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+template <byte N>
+class TinyGPSPoolRunner
+{
+public:
+  typedef typename TinyGPSPool<N>::Chunk Chunk;
+
+  explicit TinyGPSPoolRunner(TinyGPSPool<N> &pool) : _pool(pool) {}
+
+  // parses the batch on `threads` workers (0 for one per core, never more
+  // than the streams in the batch), returns the number of validated
+  // sentences. Chunks for unknown streams are ignored. The calling thread
+  // is one of the workers, and all have finished when run() returns.
+  unsigned long run(const Chunk *chunks, size_t count, unsigned threads = 0)
+  {
+    if (!threads)
+      threads = std::thread::hardware_concurrency();
+    if (!threads)
+      threads = 1;
+
+    // counting sort by stream: _first[s] is where stream s starts in _order
+    size_t bytes[N];
+    size_t count_of[N];
+    for (unsigned s = 0; s < N; ++s)
+      count_of[s] = bytes[s] = 0;
+    for (size_t i = 0; i < count; ++i)
+      if (chunks[i].stream < N)
+      {
+        ++count_of[chunks[i].stream];
+        bytes[chunks[i].stream] += chunks[i].len;
+      }
+    _first[0] = 0;
+    for (unsigned s = 0; s < N; ++s)
+      _first[s + 1] = _first[s] + count_of[s];
+    _order.resize(_first[N]);
+    for (unsigned s = 0; s < N; ++s)
+      count_of[s] = _first[s];
+    for (size_t i = 0; i < count; ++i)
+      if (chunks[i].stream < N)
+        _order[count_of[chunks[i].stream]++] = i;
+
+    // the streams with data, largest first
+    byte streams = 0;
+    for (unsigned s = 0; s < N; ++s)
+      if (bytes[s])
+      {
+        byte at = streams++;
+        for (; at > 0 && bytes[_queue[at - 1]] < bytes[s]; --at)
+          _queue[at] = _queue[at - 1];
+        _queue[at] = s;
+      }
+    if (threads > streams)
+      threads = streams ? streams : 1;
+
+    std::atomic<unsigned> next(0);
+    std::atomic<unsigned long> valid_sentences(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t)
+      workers.push_back(std::thread(&TinyGPSPoolRunner::work, this, chunks, streams,
+        std::ref(next), std::ref(valid_sentences)));
+    work(chunks, streams, next, valid_sentences);
+    for (size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+    return valid_sentences;
+  }
+
+private:
+  TinyGPSPool<N> &_pool;
+  std::vector<size_t> _order; // chunk indices grouped by stream, kept between runs
+  size_t _first[N + 1];
+  byte _queue[N];
+
+  void work(const Chunk *chunks, byte streams, std::atomic<unsigned> &next,
+    std::atomic<unsigned long> &valid_sentences)
+  {
+    unsigned long mine = 0;
+    for (unsigned claim; (claim = next++) < streams; )
+    {
+      byte s = _queue[claim];
+      for (size_t i = _first[s]; i < _first[s + 1]; ++i)
+        mine += _pool.encode(s, chunks[_order[i]].buf, chunks[_order[i]].len);
+    }
+    valid_sentences += mine;
+  }
+
+  TinyGPSPoolRunner(const TinyGPSPoolRunner &);
+  TinyGPSPoolRunner &operator = (const TinyGPSPoolRunner &);
+};
+
+#endif
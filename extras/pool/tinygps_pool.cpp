@@ -0,0 +1,146 @@
+/*
+tinygps_pool - feeds a recorded NMEA log to every stream of a TinyGPSPool
+as interleaved chunks, parses the batch with TinyGPSPoolRunner and checks
+each stream against one TinyGPS fed the same bytes sequentially.
+
+Build from the library root:
+
+  g++ -O2 -std=gnu++11 -pthread -DARDUINO=100 -Iextras/host -I. \
+    -Iextras/replay extras/pool/tinygps_pool.cpp \
+    extras/replay/TinyGPSReplay.cpp extras/host/Arduino.cpp TinyGPS.cpp \
+    -o tinygps_pool
+
+Run:
+
+  ./tinygps_pool [-j threads] [-b burst] [log.nmea]
+
+With no log file, extras/bench/sample.nmea is used. Stream 0 receives the
+log `burst` times (8 by default), the other streams once, so one port is
+busier than the rest.
+*/
+
+#include "TinyGPSPoolRunner.h"
+#include "TinyGPSReplay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#define STREAMS 8
+
+typedef TinyGPSPool<STREAMS> Pool;
+
+static double now_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool read_log(const char *path, std::vector<char> &log)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+  char buf[4096];
+  for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0; )
+    log.insert(log.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned threads = 0, burst = 8;
+  const char *path = "extras/bench/sample.nmea";
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "-j") && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+      burst = atoi(argv[++i]);
+    else
+      path = argv[i];
+  }
+
+  std::vector<char> log;
+  if (!read_log(path, log) || log.empty())
+  {
+    fprintf(stderr, "usage: %s [-j threads] [-b burst] [log.nmea]\n", argv[0]);
+    return 2;
+  }
+
+  // each stream's bytes, then the batch: chunks of 1 to 64 bytes, dealt
+  // round-robin across the streams that still have bytes left
+  std::vector<char> data[STREAMS];
+  for (byte s = 0; s < STREAMS; ++s)
+    for (unsigned n = s ? 1 : burst; n > 0; --n)
+      data[s].insert(data[s].end(), log.begin(), log.end());
+  std::vector<Pool::Chunk> batch;
+  size_t offset[STREAMS] = { 0 };
+  unsigned seed = 1;
+  for (bool more = true; more; )
+  {
+    more = false;
+    for (byte s = 0; s < STREAMS; ++s)
+    {
+      size_t left = data[s].size() - offset[s];
+      if (!left)
+        continue;
+      seed = seed * 1103515245 + 12345;
+      size_t len = 1 + (seed >> 16) % 64;
+      if (len > left)
+        len = left;
+      Pool::Chunk chunk = { s, &data[s][offset[s]], len };
+      batch.push_back(chunk);
+      offset[s] += len;
+      more = true;
+    }
+  }
+
+  static Pool pool;
+  unsigned long clocks[STREAMS] = { 0 };
+  for (byte s = 0; s < STREAMS; ++s)
+    pool[s].set_clock(TinyGPSReplay::count_clock, &clocks[s]);
+  TinyGPSPoolRunner<STREAMS> runner(pool);
+  double start = now_seconds();
+  unsigned long sentences = runner.run(&batch[0], batch.size(), threads);
+  double seconds = now_seconds() - start;
+
+  size_t total = 0;
+  for (byte s = 0; s < STREAMS; ++s)
+    total += data[s].size();
+  printf("%u streams, %u chunks, %u bytes, %lu validated sentences in %.3f s\n",
+    STREAMS, (unsigned)batch.size(), (unsigned)total, sentences, seconds);
+
+  for (byte s = 0; s < STREAMS; ++s)
+  {
+    TinyGPS gps;
+    unsigned long clock = 0;
+    gps.set_clock(TinyGPSReplay::count_clock, &clock);
+    gps.encode(&data[s][0], data[s].size());
+    TinyGPS::Fix a, b;
+    gps.get_fix(a);
+    pool[s].get_fix(b);
+    if (!TinyGPSReplay::same_fix(a, b))
+    {
+      printf("MISMATCH in stream %u's fix\n", s);
+      return 1;
+    }
+#ifndef _GPS_NO_STATS
+    TinyGPS::Stats sa, sb;
+    gps.get_stats(sa);
+    pool[s].get_stats(sb);
+    if (memcmp(&sa, &sb, sizeof(sa)))
+    {
+      printf("MISMATCH in stream %u's statistics\n", s);
+      return 1;
+    }
+#endif
+  }
+  printf("verified: every stream matches a sequential parse\n");
+  return 0;
+}
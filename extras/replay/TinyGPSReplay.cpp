@@ -0,0 +1,276 @@
+/*
+TinyGPSReplay - parallel replay of recorded NMEA logs on POSIX hosts
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+*/
+
+#include "TinyGPSReplay.h"
+
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct ReplayCommit
+{
+  uint16_t changed;
+  TinyGPS::Fix fix;
+};
+
+// the results of one chunk, waiting to be merged
+struct ReplaySlot
+{
+  std::vector<ReplayCommit> commits;
+  unsigned long valid_sentences;
+#ifndef _GPS_NO_STATS
+  TinyGPS::Stats stats;
+#endif
+  unsigned long clock; // sentences begun, the chunk's receive times
+  bool ready;
+  uint16_t fix_time; // the on_time() mask due for the commit on_fix() recorded
+};
+
+/* static */
+unsigned long TinyGPSReplay::count_clock(void *context)
+{
+  return (*(unsigned long *)context)++;
+}
+
+static void record(ReplaySlot *slot, TinyGPS &gps, uint16_t changed)
+{
+  ReplayCommit commit;
+  commit.changed = changed;
+  gps.get_fix(commit.fix);
+  slot->commits.push_back(commit);
+}
+
+// A commit with a fix calls on_fix(), then on_time() straight after it
+// only if it carried the time or date. A commit without a fix calls
+// on_time() alone.
+static void collect_fix(TinyGPS &gps, uint16_t changed, void *context)
+{
+  ReplaySlot *slot = (ReplaySlot *)context;
+  record(slot, gps, changed);
+  slot->fix_time = changed & (TinyGPS::GPS_CHANGED_TIME | TinyGPS::GPS_CHANGED_DATE);
+}
+
+static void collect_time(TinyGPS &gps, uint16_t changed, void *context)
+{
+  ReplaySlot *slot = (ReplaySlot *)context;
+  if (slot->fix_time)
+    slot->fix_time = 0; // already recorded by collect_fix()
+  else
+    record(slot, gps, changed);
+}
+
+TinyGPSReplay::TinyGPSReplay()
+  :  _data(0)
+  ,  _size(0)
+#ifndef _GPS_NO_STATS
+  ,  _stats()
+#endif
+{
+  TinyGPS().get_fix(_fix);
+}
+
+TinyGPSReplay::~TinyGPSReplay()
+{
+  close();
+}
+
+bool TinyGPSReplay::open(const char *path)
+{
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size > 0)
+  {
+    void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+    {
+      ::close(fd);
+      return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    _data = (const char *)p;
+    _size = st.st_size;
+  }
+  ::close(fd); // the mapping keeps the file open
+  return true;
+}
+
+void TinyGPSReplay::close()
+{
+  if (_data)
+    munmap((void *)_data, _size);
+  _data = 0;
+  _size = 0;
+}
+
+// A chunk starts at the first '$' at or after its nominal offset, so a
+// sentence is never split and every parser starts where a '$' would have
+// reset a sequential one
+size_t TinyGPSReplay::chunk_start(size_t chunk, size_t chunk_size) const
+{
+  if (chunk == 0)
+    return 0;
+  size_t at = chunk * chunk_size;
+  if (at >= _size)
+    return _size;
+  const char *dollar = (const char *)memchr(_data + at, '$', _size - at);
+  return dollar ? dollar - _data : _size;
+}
+
+unsigned long TinyGPSReplay::run(Callback cb, void *context, unsigned threads, size_t chunk_size)
+{
+  if (!threads)
+    threads = std::thread::hardware_concurrency();
+  if (!threads)
+    threads = 1;
+  if (!chunk_size)
+    chunk_size = 1;
+
+  TinyGPS().get_fix(_fix);
+#ifndef _GPS_NO_STATS
+  _stats = TinyGPS::Stats();
+#endif
+
+  // at most `window` chunks are parsed ahead of the merge
+  const size_t chunks = (_size + chunk_size - 1) / chunk_size;
+  const size_t window = 2 * threads;
+  std::vector<ReplaySlot> slots(window);
+  for (size_t i = 0; i < window; ++i)
+    slots[i].ready = false;
+  std::mutex lock;
+  std::condition_variable progress;
+  size_t next = 0, merged = 0;
+
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t)
+    workers.push_back(std::thread([&]()
+    {
+      for (;;)
+      {
+        size_t chunk;
+        {
+          std::unique_lock<std::mutex> guard(lock);
+          progress.wait(guard, [&]() { return next >= chunks || next < merged + window; });
+          if (next >= chunks)
+            return;
+          chunk = next++;
+        }
+
+        ReplaySlot &slot = slots[chunk % window];
+        size_t start = chunk_start(chunk, chunk_size);
+        size_t end = chunk_start(chunk + 1, chunk_size);
+        slot.fix_time = 0;
+        slot.clock = 0;
+        TinyGPS gps;
+        gps.set_clock(count_clock, &slot.clock);
+        gps.on_fix(collect_fix, &slot);
+        gps.on_time(collect_time, &slot);
+        slot.valid_sentences = gps.encode(_data + start, end - start);
+#ifdef _GPS_MERGE_EPOCHS
+        gps.end_epoch();
+#endif
+#ifndef _GPS_NO_STATS
+        gps.get_stats(slot.stats);
+#endif
+
+        std::lock_guard<std::mutex> guard(lock);
+        slot.ready = true;
+        progress.notify_all();
+      }
+    }));
+
+  unsigned long valid_sentences = 0, clock = 0;
+  while (merged < chunks)
+  {
+    ReplaySlot &slot = slots[merged % window];
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      progress.wait(guard, [&]() { return slot.ready; });
+    }
+
+    for (size_t i = 0; i < slot.commits.size(); ++i)
+    {
+      // the chunk counted its sentences from 0
+      TinyGPS::Fix &fix = slot.commits[i].fix;
+      fix.time_fix += clock;
+      fix.position_fix += clock;
+#ifndef _GPS_NO_ZDA
+      fix.date_fix += clock;
+#endif
+      TinyGPS::copy_fields(slot.commits[i].changed, fix, _fix);
+      if (cb)
+        cb(slot.commits[i].changed, _fix, context);
+    }
+    valid_sentences += slot.valid_sentences;
+    clock += slot.clock;
+#ifndef _GPS_NO_STATS
+    _stats.encoded_characters += slot.stats.encoded_characters;
+    _stats.skipped_characters += slot.stats.skipped_characters;
+    _stats.good_sentences += slot.stats.good_sentences;
+    _stats.passed_checksum += slot.stats.passed_checksum;
+    _stats.failed_checksum += slot.stats.failed_checksum;
+    _stats.no_fix += slot.stats.no_fix;
+    _stats.term_truncations += slot.stats.term_truncations;
+    for (byte i = 0; i < TinyGPS::_GPS_SENTENCE_COUNT; ++i)
+    {
+      _stats.accepted[i] += slot.stats.accepted[i];
+      _stats.rejected[i] += slot.stats.rejected[i];
+    }
+    if (slot.stats.max_sentence_length > _stats.max_sentence_length)
+      _stats.max_sentence_length = slot.stats.max_sentence_length;
+#endif
+    slot.commits.clear();
+
+    std::lock_guard<std::mutex> guard(lock);
+    slot.ready = false;
+    ++merged;
+    progress.notify_all();
+  }
+
+  for (size_t t = 0; t < workers.size(); ++t)
+    workers[t].join();
+  return valid_sentences;
+}
+
+/* static */
+bool TinyGPSReplay::same_fix(const TinyGPS::Fix &a, const TinyGPS::Fix &b)
+{
+  return a.time_fix == b.time_fix && a.position_fix == b.position_fix &&
+#ifndef _GPS_NO_ZDA
+    a.date_fix == b.date_fix &&
+#endif
+    a.time == b.time && a.date == b.date && a.latitude == b.latitude &&
+    a.longitude == b.longitude && a.altitude == b.altitude && a.speed == b.speed &&
+#ifndef _GPS_NO_ZDA
+    a.year == b.year && a.month == b.month && a.day == b.day &&
+#endif
+#ifndef _GPS_NO_EPOCH
+    a.utc.epoch == b.utc.epoch && a.utc.year == b.utc.year && a.utc.month == b.utc.month &&
+    a.utc.day == b.utc.day && a.utc.hour == b.utc.hour && a.utc.minute == b.utc.minute &&
+    a.utc.second == b.utc.second && a.utc.hundredths == b.utc.hundredths &&
+#endif
+#ifndef _GPS_NO_KINEMATICS
+    a.velocity.speed == b.velocity.speed && a.velocity.north == b.velocity.north &&
+    a.velocity.east == b.velocity.east && a.velocity.down == b.velocity.down &&
+#endif
+#ifdef _GPS_HIGH_PRECISION
+    a.latitude_nano == b.latitude_nano && a.longitude_nano == b.longitude_nano &&
+    a.altitude_mm == b.altitude_mm &&
+#endif
+    a.course == b.course && a.hdop == b.hdop && a.numsats == b.numsats;
+}
@@ -0,0 +1,78 @@
+/*
+TinyGPSReplay - parallel replay of recorded NMEA logs on POSIX hosts
+Part of the TinyGPS library, see TinyGPS.h for copyright and license.
+
+The log is memory mapped and cut into chunks at '$' sentence starts. Each
+chunk is parsed by its own TinyGPS on a worker thread, and the fixes the
+chunks committed are merged back in log order. A sentence commits only the
+fields it carried, so the merged result matches one TinyGPS fed the whole
+log. Receive times (time_fix, position_fix, date_fix) come from a clock
+that counts the sentences of the log, so the n-th sentence is received
+at time n, whichever thread parsed it, and a sequential parse with
+count_clock() gets the same times. The satellite table and
+constellations are per-chunk and are not merged. Under _GPS_MERGE_EPOCHS
+each chunk ends its last epoch, so an epoch split across two chunks is
+committed twice; replay such a log with a single chunk to compare it. A
+log with UBX binary frames may have a '$' inside a frame; replay it with
+a single chunk.
+
+Build with the library and the host shim, C++11 and -pthread, see
+tinygps_replay.cpp.
+*/
+
+#ifndef TinyGPSReplay_h
+#define TinyGPSReplay_h
+
+#include "TinyGPS.h"
+
+#ifdef _GPS_NO_CALLBACKS
+#error "TinyGPSReplay collects commits through the TinyGPS callbacks"
+#endif
+
+class TinyGPSReplay
+{
+public:
+  // called in log order for every commit; fix is the merged state after it
+  typedef void (*Callback)(uint16_t changed, const TinyGPS::Fix &fix, void *context);
+
+  TinyGPSReplay();
+  ~TinyGPSReplay();
+
+  // maps a log file, returns false (with errno set) if it cannot be read
+  bool open(const char *path);
+  void close();
+  const char *data() const { return _data; }
+  size_t size() const { return _size; }
+
+  // parses the log on `threads` workers (0 for one per core) in chunks of
+  // about chunk_size bytes, returns the number of validated sentences
+  unsigned long run(Callback cb = 0, void *context = 0, unsigned threads = 0,
+    size_t chunk_size = 4UL << 20);
+
+  // the merged fix after run()
+  const TinyGPS::Fix &fix() const { return _fix; }
+#ifndef _GPS_NO_STATS
+  // the chunks' statistics, summed
+  const TinyGPS::Stats &stats() const { return _stats; }
+#endif
+
+  // true if every field TinyGPS::copy_fields() copies is equal
+  static bool same_fix(const TinyGPS::Fix &a, const TinyGPS::Fix &b);
+  // a TinyGPS::Clock that returns and advances the unsigned long at context
+  static unsigned long count_clock(void *context);
+
+private:
+  const char *_data;
+  size_t _size;
+  TinyGPS::Fix _fix;
+#ifndef _GPS_NO_STATS
+  TinyGPS::Stats _stats;
+#endif
+
+  size_t chunk_start(size_t chunk, size_t chunk_size) const;
+
+  TinyGPSReplay(const TinyGPSReplay &);
+  TinyGPSReplay &operator = (const TinyGPSReplay &);
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+tinygps_replay - replays a recorded NMEA log through TinyGPSReplay and
+prints the merged result, optionally checking it against one TinyGPS fed
+the whole log sequentially.
+
+Build from the library root:
+
+  g++ -O2 -std=gnu++11 -pthread -DARDUINO=100 -Iextras/host -I. \
+    extras/replay/tinygps_replay.cpp extras/replay/TinyGPSReplay.cpp \
+    extras/host/Arduino.cpp TinyGPS.cpp -o tinygps_replay
+
+Run:
+
+  ./tinygps_replay [-j threads] [-c chunk_bytes] [-v] log.nmea
+
+-v also parses the log sequentially and compares every commit.
+*/
+
+#include "TinyGPSReplay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+struct Commit
+{
+  uint16_t changed;
+  TinyGPS::Fix fix;
+};
+
+static void collect(uint16_t changed, const TinyGPS::Fix &fix, void *context)
+{
+  Commit commit;
+  commit.changed = changed;
+  commit.fix = fix;
+  ((std::vector<Commit> *)context)->push_back(commit);
+}
+
+// the sequential reference: the same merge, fed by a single TinyGPS
+struct Sequential
+{
+  std::vector<Commit> commits;
+  TinyGPS::Fix fix;
+  uint16_t fix_time; // as ReplaySlot::fix_time
+};
+
+static void sequential_record(Sequential *s, TinyGPS &gps, uint16_t changed)
+{
+  TinyGPS::Fix fix;
+  gps.get_fix(fix);
+  TinyGPS::copy_fields(changed, fix, s->fix);
+  collect(changed, s->fix, &s->commits);
+}
+
+static void sequential_fix(TinyGPS &gps, uint16_t changed, void *context)
+{
+  Sequential *s = (Sequential *)context;
+  sequential_record(s, gps, changed);
+  s->fix_time = changed & (TinyGPS::GPS_CHANGED_TIME | TinyGPS::GPS_CHANGED_DATE);
+}
+
+static void sequential_time(TinyGPS &gps, uint16_t changed, void *context)
+{
+  Sequential *s = (Sequential *)context;
+  if (s->fix_time)
+    s->fix_time = 0;
+  else
+    sequential_record(s, gps, changed);
+}
+
+static double now_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int verify(TinyGPSReplay &replay, const std::vector<Commit> &commits)
+{
+  Sequential s;
+  TinyGPS gps;
+  unsigned long clock = 0;
+  gps.set_clock(TinyGPSReplay::count_clock, &clock);
+  gps.get_fix(s.fix);
+  s.fix_time = 0;
+  gps.on_fix(sequential_fix, &s);
+  gps.on_time(sequential_time, &s);
+  double start = now_seconds();
+  gps.encode(replay.data(), replay.size());
+#ifdef _GPS_MERGE_EPOCHS
+  gps.end_epoch();
+#endif
+  printf("sequential: %.3f s\n", now_seconds() - start);
+
+  if (s.commits.size() != commits.size())
+  {
+    printf("MISMATCH: %u sequential commits, %u replayed\n",
+      (unsigned)s.commits.size(), (unsigned)commits.size());
+    return 1;
+  }
+  for (size_t i = 0; i < commits.size(); ++i)
+    if (s.commits[i].changed != commits[i].changed || !TinyGPSReplay::same_fix(s.commits[i].fix, commits[i].fix))
+    {
+      printf("MISMATCH at commit %u\n", (unsigned)i);
+      return 1;
+    }
+#ifndef _GPS_NO_STATS
+  TinyGPS::Stats stats;
+  gps.get_stats(stats);
+  if (memcmp(&stats, &replay.stats(), sizeof(stats)))
+  {
+    printf("MISMATCH in statistics\n");
+    return 1;
+  }
+#endif
+  printf("verified: %u commits identical\n", (unsigned)commits.size());
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned threads = 0;
+  size_t chunk_size = 4UL << 20;
+  bool check = false;
+  const char *path = 0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "-j") && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      chunk_size = strtoul(argv[++i], 0, 0);
+    else if (!strcmp(argv[i], "-v"))
+      check = true;
+    else
+      path = argv[i];
+  }
+  if (!path)
+  {
+    fprintf(stderr, "usage: %s [-j threads] [-c chunk_bytes] [-v] log.nmea\n", argv[0]);
+    return 2;
+  }
+
+  TinyGPSReplay replay;
+  if (!replay.open(path))
+  {
+    perror(path);
+    return 1;
+  }
+
+  std::vector<Commit> commits;
+  double start = now_seconds();
+  unsigned long sentences = replay.run(check ? collect : 0, &commits, threads, chunk_size);
+  double seconds = now_seconds() - start;
+
+  const TinyGPS::Fix &fix = replay.fix();
+  printf("%u bytes, %lu validated sentences in %.3f s (%.1f MB/s)\n",
+    (unsigned)replay.size(), sentences, seconds, replay.size() / seconds / 1e6);
+  printf("last fix: lat=%ld lon=%ld date=%lu time=%lu alt=%ld\n",
+    fix.latitude, fix.longitude, fix.date, fix.time, fix.altitude);
+#ifndef _GPS_NO_STATS
+  const TinyGPS::Stats &stats = replay.stats();
+  printf("checksums passed=%lu failed=%lu\n", stats.passed_checksum, stats.failed_checksum);
+#endif
+
+  return check ? verify(replay, commits) : 0;
+}
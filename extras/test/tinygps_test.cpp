@@ -0,0 +1,234 @@
+/*
+tinygps_test - regression checks for TinyGPS on a desktop host, one
+function per reported bug, each feeding the input that showed it.
+
+Build from the library root:
+
+  g++ -O2 -std=gnu++11 -pthread -DARDUINO=100 -Iextras/host -I. \
+    extras/test/tinygps_test.cpp extras/replay/TinyGPSReplay.cpp \
+    extras/host/Arduino.cpp TinyGPS.cpp -o tinygps_test
+
+Run it from the library root; the exit status is the number of checks
+that failed. Build again with the same -D switches as the fuzz harness to
+check those variants, leaving out TinyGPSReplay.cpp with _GPS_NO_CALLBACKS.
+*/
+
+#include "TinyGPS.h"
+#ifndef _GPS_NO_CALLBACKS
+#include "../replay/TinyGPSReplay.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static int failures;
+
+#define CHECK(cond) check(cond, #cond, __FUNCTION__, __LINE__)
+
+static void check(bool ok, const char *what, const char *test, int line)
+{
+  if (!ok)
+  {
+    printf("FAILED: %s, line %d: %s\n", test, line, what);
+    ++failures;
+  }
+}
+
+// a sentence with its checksum and line ending, body from the talker on
+static std::string sentence(const char *body)
+{
+  byte checksum = 0;
+  for (const char *p = body; *p; ++p)
+    checksum ^= *p;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+  return std::string("$") + body + tail;
+}
+
+static unsigned int encode(TinyGPS &gps, const std::string &s)
+{
+  return gps.encode(s.data(), s.size());
+}
+
+#ifndef _GPS_NO_UBX
+// 0xB5 0x62 and a header announcing a 32K NAV-PVT, then NMEA: the header
+// is rejected, and the sentences after it parsed
+static void stray_ubx_sync()
+{
+  static const char stray[] = { (char)0xB5, 0x62, 0x01, 0x07, (char)0xFF, 0x7F };
+  std::string gga = sentence("GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+  TinyGPS gps;
+  unsigned int valid = encode(gps, sentence("GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W"));
+  valid += gps.encode(stray, sizeof(stray));
+  for (int i = 0; i < 39; ++i)
+    valid += encode(gps, gga);
+#ifdef _GPS_MERGE_EPOCHS
+  gps.end_epoch();
+#endif
+  CHECK(valid == 40);
+  CHECK(gps.altitude() == 54540);
+#ifndef _GPS_NO_STATS
+  TinyGPS::Stats stats;
+  gps.get_stats(stats);
+  CHECK(stats.failed_checksum == 1);
+  CHECK(stats.rejected[TinyGPS::_GPS_SENTENCE_UBX] == 1);
+#endif
+
+  // one byte at a time, and with a '$' in the header parsed again
+  static const char dollar[] = { (char)0xB5, 0x62, 0x01, '$', (char)0xFF, (char)0xFF };
+  TinyGPS bytes;
+  valid = 0;
+  for (size_t i = 0; i < sizeof(dollar); ++i)
+    valid += bytes.encode(&dollar[i], 1);
+  for (size_t i = 0; i < gga.size(); ++i)
+    valid += bytes.encode(gga[i]);
+  CHECK(valid == 1);
+}
+
+static unsigned long count_clock(void *context)
+{
+  return ++*(unsigned long *)context;
+}
+
+// a UBX frame of a message not decoded, here ACK-ACK, between the messages
+// of a GSV sequence: it is counted, and neither reads the clock nor
+// disturbs the sequence
+static void ubx_between_gsv()
+{
+  static const char ack[] = { (char)0xB5, 0x62, 0x05, 0x01, 0x02, 0x00, 0x06, 0x01, 0x0F, 0x38 };
+  std::string gsv1 = sentence("GPGSV,2,1,05,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45");
+  std::string gsv2 = sentence("GPGSV,2,2,05,15,55,120,40");
+  unsigned long reads[2] = { 0, 0 };
+  for (int frame = 0; frame < 2; ++frame)
+  {
+    TinyGPS gps;
+    gps.set_clock(count_clock, &reads[frame]);
+    encode(gps, gsv1);
+    if (frame)
+      gps.encode(ack, sizeof(ack));
+    encode(gps, gsv2);
+#ifndef _GPS_NO_GSV
+    CHECK(gps.sky().count() == 5);
+#endif
+#ifndef _GPS_NO_STATS
+    TinyGPS::Stats stats;
+    gps.get_stats(stats);
+    CHECK(stats.accepted[TinyGPS::_GPS_SENTENCE_UBX] == (frame ? 1U : 0U));
+    CHECK(stats.failed_checksum == 0);
+#endif
+  }
+  CHECK(reads[1] == reads[0]);
+}
+#endif
+
+#ifndef _GPS_NO_VTG
+#ifndef _GPS_NO_CALLBACKS
+static void count_fix(TinyGPS &, uint16_t changed, void *context)
+{
+  *(uint16_t *)context = changed;
+}
+#endif
+
+// a VTG commits course and speed unless its NMEA 2.3 mode term is N, and
+// one from before NMEA 2.3 has no mode term at all
+static void vtg_forms()
+{
+  static const struct { const char *body; bool fix; } cases[] = {
+    { "GPVTG,77.52,T,,M,5.0,N,9.26,K", true },
+    { "GPVTG,77.52,T,,M,5.0,N,9.26,K,A", true },
+    { "GPVTG,77.52,T,,M,5.0,N,9.26,K,D", true },
+    { "GPVTG,77.52,T,,M,5.0,N,9.26,K,N", false },
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+  {
+    TinyGPS gps;
+    encode(gps, sentence("GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W"));
+#ifdef _GPS_MERGE_EPOCHS
+    gps.end_epoch();
+#endif
+#ifndef _GPS_NO_CALLBACKS
+    uint16_t changed = 0;
+    gps.on_fix(count_fix, &changed);
+#endif
+    unsigned int valid = encode(gps, sentence(cases[i].body));
+#ifdef _GPS_MERGE_EPOCHS
+    gps.end_epoch();
+#endif
+    CHECK(valid == (cases[i].fix ? 1U : 0U));
+    CHECK(gps.course() == (cases[i].fix ? 7752UL : 8440UL));
+    CHECK(gps.speed() == (cases[i].fix ? 500UL : 2240UL));
+#ifndef _GPS_NO_CALLBACKS
+    CHECK(changed == (cases[i].fix ? TinyGPS::GPS_CHANGED_SPEED | TinyGPS::GPS_CHANGED_COURSE : 0));
+#endif
+  }
+}
+#endif
+
+#if !defined(_GPS_NO_CALLBACKS) && !defined(_GPS_NO_VTG) && !defined(_GPS_NO_ZDA)
+static void collect(uint16_t changed, const TinyGPS::Fix &, void *context)
+{
+  ((std::vector<uint16_t> *)context)->push_back(changed);
+}
+
+// RMC, VTG, ZDA, then a GGA without a time: the VTG's on_fix() is not
+// followed by an on_time(), and the ZDA's on_time() must still be kept
+static void replay_vtg_then_zda()
+{
+  std::string log =
+    sentence("GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W") +
+    sentence("GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A") +
+    sentence("GPZDA,123520,23,03,1994,00,00") +
+    sentence("GPGGA,,4807.040,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+  char path[] = "/tmp/tinygps_testXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  if (fd < 0)
+    return;
+  CHECK(write(fd, log.data(), log.size()) == (ssize_t)log.size());
+  close(fd);
+
+  TinyGPSReplay replay;
+  CHECK(replay.open(path));
+  unlink(path);
+  // in one chunk, and in one chunk per sentence, which would split an
+  // epoch under _GPS_MERGE_EPOCHS
+  static const size_t chunk_sizes[] = { 4096, 1 };
+#ifndef _GPS_MERGE_EPOCHS
+  for (size_t i = 0; i < 2; ++i)
+#else
+  for (size_t i = 0; i < 1; ++i)
+#endif
+  {
+    std::vector<uint16_t> commits;
+    replay.run(collect, &commits, 2, chunk_sizes[i]);
+#ifndef _GPS_MERGE_EPOCHS
+    CHECK(commits.size() == 4);
+    CHECK(commits.size() == 4 && commits[1] == (TinyGPS::GPS_CHANGED_SPEED | TinyGPS::GPS_CHANGED_COURSE));
+    CHECK(commits.size() == 4 && (commits[2] & TinyGPS::GPS_CHANGED_YMD));
+#else
+    // the VTG joins the RMC's epoch, which the ZDA's new time ends
+    CHECK(commits.size() == 3);
+    CHECK(commits.size() == 3 && (commits[1] & TinyGPS::GPS_CHANGED_YMD));
+#endif
+  }
+}
+#endif
+
+int main()
+{
+#ifndef _GPS_NO_UBX
+  stray_ubx_sync();
+  ubx_between_gsv();
+#endif
+#ifndef _GPS_NO_VTG
+  vtg_forms();
+#endif
+#if !defined(_GPS_NO_CALLBACKS) && !defined(_GPS_NO_VTG) && !defined(_GPS_NO_ZDA)
+  replay_vtg_then_zda();
+#endif
+  printf("%s: %d failed\n", failures ? "FAILED" : "passed", failures);
+  return failures;
+}